@@ -5,12 +5,15 @@
  * 
  */
 
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
 #include <cmath>
 #include <limits>
+#include <memory>
 #include "agent.h"
 #include "world.h"
+#include "insect.h"
 
 /**
  * Creates an agent. Sets some statistical variables to zero or other reasonable values 
@@ -20,6 +23,7 @@
  */
 Agent::Agent(genome_ptr new_genome_ptr) : 
 	death_chance(0.0),
+	survival_budget(std::numeric_limits<turn_counter>::infinity()),
 	personal_fitness(0.0),
 	birth_time(-1.0),
 	death_time(-1.0),
@@ -32,6 +36,8 @@ Agent::Agent(genome_ptr new_genome_ptr) :
 		std::exit(1);
 	}
 	agent_id = next_agent_id++;
+	handle.index = 0;
+	handle.generation = 0;
 	
 	if (!new_genome_ptr) {
 		new_genome_ptr = genome_ptr(new Genome(typeid(*this)));
@@ -131,13 +137,14 @@ turn_counter Agent::accomplish_action() {
 
 /**
  * Decides if the agent dies in the given time period. Returns true if the agent will die.
- * This method uses the agents death_chance (chance to die per time unit) and a dice.
+ * The given turns are taken from the agents survival budget (see
+ * Agent::set_death_chance), the agent dies when it is used up. Because the budget is
+ * exponentially distributed, the chance to survive the period is (1 - death_chance)^turns,
+ * like with a dice thrown for every period.
  */
 bool Agent::died(const turn_counter turns) {
-	BUG_CHECK(death_chance < 0.0 || death_chance > 1.0, "Death chance out of range.");
-	double survive_chance = pow(1.0 - death_chance, turns);
-	BUG_CHECK(survive_chance < 0.0 || survive_chance > 1.0, "Survive chance out of range.");
-	bool is_dead = survive_chance < World::randone() || action_finishing_time > max_age;
+	survival_budget -= turns;
+	bool is_dead = survival_budget < 0.0 || action_finishing_time > max_age;
 	if (is_dead)
 		is_dead_now();
 	return is_dead;
@@ -227,11 +234,20 @@ void Agent::starts_to_act(const turn_counter action_duration, const turn_counter
 
 /**
  * Sets the probability of death per time unit (per 'turn') for this agent.
+ * The dice is thrown only once here: it gives the amount of turns the agent will survive
+ * (the survival budget), which Agent::died counts down. Time spent frozen is not taken
+ * from the budget, because it is no action duration.
  */
 void Agent::set_death_chance(const double new_death_chance) {
 	BUG_CHECK(new_death_chance < 0.0 || new_death_chance > 1.0, "Death chance out of " <<
 	          "range 0..1. It is: " << new_death_chance);
 	death_chance = new_death_chance;
+	if (death_chance == 0.0)
+		survival_budget = std::numeric_limits<turn_counter>::infinity();
+	else if (death_chance == 1.0)
+		survival_budget = 0.0;
+	else // 1 - randone() is never zero.
+		survival_budget = log(1.0 - World::environment_randone()) / log(1.0 - death_chance);
 }
 
 /**
@@ -259,6 +275,21 @@ bool Agent::compare_finishing_times(const agent_ptr a, const agent_ptr b) {
 	return a->action_finishing_time < b->action_finishing_time;
 }
 
+/**
+ * Returns the handle of this agent in the population of its world.
+ */
+agent_handle Agent::get_handle() const {
+	return handle;
+}
+
+/**
+ * Sets the handle of this agent in the population of its world. This is only done by
+ * the Population itself.
+ */
+void Agent::set_handle(const agent_handle new_handle) {
+	handle = new_handle;
+}
+
 /**
  * Sets the maximum noise value added to every action duration.
  */
@@ -296,6 +327,20 @@ bool Agent::has_same_type(agent_ptr other_agent) const {
 	return agent_type == other_agent->get_agent_type();
 }
 
+/**
+ * Lets several agents cognite at once. All given agents must have the same type as this
+ * one; this agent itself does not need to be among them. The action of agents[i] is
+ * written to actions[i]. The containers of scratch can be used for the work in between.
+ * This implementation asks every agent on its own. Overwrite it in a childclass if the
+ * agents can share work, like evaluating their neuronal networks together.
+ */
+void Agent::cognite_batch(const agent_ptr* agents, const perception* perceptions,
+                          action* actions, const unsigned int quantity,
+                          cognition_batch& scratch) {
+	for (unsigned i=0; i<quantity; ++i)
+		actions[i] = agents[i]->cognite(&perceptions[i]);
+}
+
 /**
  * Returns a pointer to a human readable description of the given gene number gene_no.
  * Tells only a simple Text like "Gene 3". Can be overwritten by a childclass to give
@@ -312,73 +357,188 @@ string_ptr Agent::get_gene_description(const unsigned int gene_no) {
 }
 
 /**
- * Scale a value of range 0..1 to range -1..1.
+ * Does a binary decision by computing a simulated neuronal network. As thresholds and
+ * weightings genes from the agents genome are taken. The agents variable next_gene is
+ * used incremented for every used gene. You have to set next_gene back to something
+ * (maybe zero) before you call this method.
+ * The parameters are the input signals (signals_size doubles, at most NN_MAX_SIGNALS),
+ * the amount of hidden layers, which may be zero, and the outputs per hidden layer (zero
+ * for as many as there are input signals). Narrower hidden layers need fewer genes and
+ * less computation.
+ * The genes must have the range 0..1, but for the weightings they are scaled to -1..1. 
+ * In this neuronal network connections can have negative value.
+ * The network is compiled only once per genome (see Genome::get_neuronal_network) and
+ * computed without allocating memory. With incremental networks switched on (see
+ * Agent::set_incremental_networks), the agent remembers its last computation and only
+ * computes what changed.
+ */
+bool Agent::neuronal_network(const double* signals, const unsigned int signals_size,
+                             int hidden_layer_quant,
+                             const unsigned int hidden_layer_width) {
+	BUG_CHECK(hidden_layer_quant<0, "Negative quantity of hidden layers.");
+	const NeuronalNetwork& network =
+		my_genome->get_neuronal_network(next_gene, signals_size, hidden_layer_quant,
+		                                hidden_layer_width);
+	next_gene += network.get_gene_quantity();
+	if (incremental_networks) {
+		if (!network_state)
+			network_state.reset(new nn_state);
+		return network.decide_incrementally(signals, *network_state);
+	}
+	return network.decide(signals);
+}
+
+/**
+ * Computes the neuronal network with the standard quantity of hidden layers and the
+ * hidden layer width of the agent type (see Agent::set_nn_hidden_width).
  */
-inline double Agent::scale(double val) {
-	return (val - 0.5) * 2.0;
+bool Agent::neuronal_network(const double* signals, const unsigned int signals_size) {
+	return neuronal_network(signals, signals_size, hidden_layers,
+	                        get_nn_hidden_width(my_genome->get_type_id()));
 }
 
 /**
- * Computes one layer in a simulated neuronal network.
- * It sums up the weighted input signals for every output signal.
- * This method is used by Agent::neuronal_network. Read the comment there if you want to
- * know more about it.
+ * Computes the neuronal networks of several agents at once, like
+ * Agent::neuronal_network does it for one. The input signals of all agents (signals_size
+ * per agent) are given one after another in signals, the decisions are written to
+ * decisions. Agents with the same genome and the same next_gene share one network, their
+ * inputs are computed together (see NeuronalNetwork::decide_batch). So the work mostly
+ * depends on the quantity of different genomes.
+ * The groups are found with a hash table on the genome and next_gene and kept as lists
+ * in scratch, so this takes linear time and allocates nothing. They are computed in the
+ * order of their first agents, in parts of up to NN_BATCH_SIZE agents.
+ * Incremental networks are computed one by one.
  */
-nn_signals_ptr Agent::neuronal_layer(unsigned int output_sigs_size, nn_signals_ptr input_signals, bool negative_genes) {
-	nn_signals_ptr output_sigs = nn_signals_ptr(new nn_signals(output_sigs_size, 0.0));
-	BUG_CHECK(output_sigs->size()!=output_sigs_size, "Wrong output sigs size.");
+void Agent::neuronal_networks(Agent* const* agents, const double* signals,
+                              const unsigned int signals_size, const unsigned int quantity,
+                              bool* decisions, cognition_batch& scratch) {
+	BUG_CHECK(signals_size>NN_MAX_SIGNALS, "Too many input signals for neuronal network: "
+	          << signals_size);
+	if (incremental_networks) {
+		for (unsigned n=0; n<quantity; ++n)
+			decisions[n] = agents[n]->neuronal_network(&signals[n * signals_size],
+			                                           signals_size);
+		return;
+	}
 
-	if (negative_genes)
-		for (auto& output: *output_sigs) {
-			double signal_sum = 0.0;
-			for (auto& input: *input_signals)
-				signal_sum += input * scale(get_genome_ptr()->get_gene(next_gene++));
-			output = (signal_sum > get_genome_ptr()->get_gene(next_gene++));			
+	// The table has at least twice as many entries as there are agents.
+	unsigned int table_bits = 1;
+	while ((1u << table_bits) < 2 * quantity)
+		++table_bits;
+	const unsigned int table_mask = (1u << table_bits) - 1;
+	scratch.group_table.assign(1u << table_bits, NOT_GROUPED);
+	scratch.group_firsts.clear();
+	scratch.group_lasts.clear();
+	scratch.next_members.resize(quantity);
+	for (unsigned n=0; n<quantity; ++n) {
+		const Agent* member = agents[n];
+		unsigned long long key = (unsigned long long)member->my_genome.get() +
+			member->next_gene;
+		unsigned int entry = (key * 0x9e3779b97f4a7c15ull) >> (64 - table_bits);
+		while (true) {
+			unsigned int group = scratch.group_table[entry];
+			if (group == NOT_GROUPED) {
+				scratch.group_table[entry] = scratch.group_firsts.size();
+				scratch.group_firsts.push_back(n);
+				scratch.group_lasts.push_back(n);
+				break;
+			}
+			const Agent* leader = agents[scratch.group_firsts[group]];
+			if (leader->my_genome == member->my_genome &&
+			    leader->next_gene == member->next_gene) {
+				scratch.next_members[scratch.group_lasts[group]] = n;
+				scratch.group_lasts[group] = n;
+				break;
+			}
+			entry = (entry + 1) & table_mask;
 		}
-	else
-		for (auto& output: *output_sigs) {
-			double signal_sum = 0.0;
-			for (auto& input: *input_signals)
-				signal_sum += input * get_genome_ptr()->get_gene(next_gene++);
-			output = (signal_sum > get_genome_ptr()->get_gene(next_gene++));
+		scratch.next_members[n] = NOT_GROUPED;
+	}
+
+	for (auto const first: scratch.group_firsts) {
+		const Agent* leader = agents[first];
+		const NeuronalNetwork& network =
+			leader->my_genome->get_neuronal_network(
+				leader->next_gene, signals_size, hidden_layers,
+				get_nn_hidden_width(leader->my_genome->get_type_id()));
+		unsigned int n = first;
+		while (n != NOT_GROUPED) {
+			double member_signals[NN_BATCH_SIZE * NN_MAX_SIGNALS];
+			unsigned int members[NN_BATCH_SIZE];
+			bool member_decisions[NN_BATCH_SIZE];
+			unsigned int part = 0;
+			for (; n != NOT_GROUPED && part < NN_BATCH_SIZE; n = scratch.next_members[n]) {
+				std::copy(&signals[n * signals_size], &signals[(n + 1) * signals_size],
+				          &member_signals[part * signals_size]);
+				members[part++] = n;
+			}
+			network.decide_batch(member_signals, part, member_decisions);
+			for (unsigned m=0; m<part; ++m) {
+				agents[members[m]]->next_gene += network.get_gene_quantity();
+				decisions[members[m]] = member_decisions[m];
+			}
 		}
-	
-	return output_sigs;
+	}
+}
+
+void Agent::set_nn_hidden_layers(const unsigned int new_nn_layers) {
+	hidden_layers = new_nn_layers;
 }
 
 /**
- * Does a binary decision by computing a simulated neuronal network. As thresholds and
- * weightings genes from the agents genome are taken. The agents variable next_gene is
- * used incremented for every used gene. You have to set next_gene back to something
- * (maybe zero) before you call this method.
- * The parameters are the input signals (a vector of doubles) and the amount of hidden
- * layers, which may be zero.
- * The genes must have the range 0..1, but for the weightings they are scaled to -1..1. 
- * In this neuronal network connections can have negative value.
+ * Sets the quantity of outputs of every hidden layer in the neuronal networks of the
+ * given agent type. Zero makes the hidden layers as wide as the input. The genomes
+ * are read following the new topology, so the genes get other meanings.
+ * This may be called while worlds run in other threads, but only from one thread at a
+ * time. At most NN_WIDTH_TYPES agent types can have a hidden layer width.
  */
-bool Agent::neuronal_network(nn_signals_ptr signals, int hidden_layer_quant) {
-	BUG_CHECK(!signals->size(), "Empty input signals container makes no sense.");
-	BUG_CHECK(hidden_layer_quant>100, "Too many hidden layers in neuronal network.");
-	unsigned int output_sigs_size = signals->size();
-
-	while (hidden_layer_quant >= 0) {
-		if (!hidden_layer_quant)
-			output_sigs_size = 1;
-		signals = neuronal_layer(output_sigs_size, signals, true);
-		--hidden_layer_quant;
-	} 
-
-	BUG_CHECK(signals->size() != 1, "Wrong output size of nn: " << signals->size());
-	return signals->at(0) > 0.5;
+void Agent::set_nn_hidden_width(const std::type_info* agent_type,
+                                const unsigned int new_width) {
+	BUG_CHECK(new_width>NN_MAX_SIGNALS, "Too wide hidden layers: " << new_width);
+	for (auto& slot: hidden_widths) {
+		const std::type_info* slot_type = slot.agent_type.load(std::memory_order_relaxed);
+		if (slot_type == agent_type) {
+			slot.width.store(new_width, std::memory_order_relaxed);
+			return;
+		}
+		if (!slot_type) {
+			// The width must be there before a reader finds the type.
+			slot.width.store(new_width, std::memory_order_relaxed);
+			slot.agent_type.store(agent_type, std::memory_order_release);
+			return;
+		}
+	}
+	BUG_CHECK(true, "Too many agent types with a hidden layer width.");
 }
 
-bool Agent::neuronal_network(nn_signals_ptr signals) {
-	return neuronal_network(signals, hidden_layers);
+/**
+ * Returns the quantity of outputs of the hidden layers for the given agent type, zero if
+ * they are as wide as the input. It takes no lock and compares at most NN_WIDTH_TYPES
+ * pointers, so it is cheap enough for every cognition.
+ */
+unsigned int Agent::get_nn_hidden_width(const std::type_info* agent_type) {
+	for (auto const& slot: hidden_widths) {
+		const std::type_info* slot_type = slot.agent_type.load(std::memory_order_acquire);
+		if (slot_type == agent_type)
+			return slot.width.load(std::memory_order_relaxed);
+		if (!slot_type)
+			break;
+	}
+	return 0;
 }
 
-void Agent::set_nn_hidden_layers(const unsigned int new_nn_layers) {
-	hidden_layers = new_nn_layers;
+/**
+ * Switches incremental computation of the neuronal networks on or off. It is faster,
+ * because between two cognitions of an agent mostly few input signals change. But the
+ * sums are rounded a bit differently, so rarely decisions differ from the ones of a
+ * complete computation. Incremental networks are always computed in double precision
+ * and without the decision cache.
+ */
+void Agent::set_incremental_networks(const bool incremental) {
+	incremental_networks = incremental;
 }
 
 unsigned int Agent::next_agent_id = 0;
 unsigned int Agent::hidden_layers = 1;
+Agent::hidden_width_slot Agent::hidden_widths[NN_WIDTH_TYPES];
+bool Agent::incremental_networks = false;
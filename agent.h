@@ -10,17 +10,21 @@
 #ifndef _AGENT_H_
 #define _AGENT_H_
 
+#include <atomic>
 #include <vector>
 #include "debug_macros.h"
 #include "world.h"
+#include "neuronal-network.h"
 
 class Genome;
 
+/** Quantity of agent types which can have their own hidden layer width (see
+    Agent::set_nn_hidden_width). */
+#define NN_WIDTH_TYPES 8
+
 class Agent;
 typedef std::shared_ptr<Agent> agent_ptr;
 
-typedef std::vector<double> nn_signals;
-typedef std::shared_ptr<nn_signals> nn_signals_ptr;
 
 
 /**
@@ -40,6 +44,8 @@ class Agent {
 		void set_max_age(turn_counter new_max_age);
 		turn_counter get_current_action_duration() const;
 		static bool compare_finishing_times(const agent_ptr a, const agent_ptr b);
+		agent_handle get_handle() const;
+		void set_handle(const agent_handle new_handle);
 		bool died(const turn_counter turns);
 		bool died();
 		turn_counter accomplish_action();
@@ -53,6 +59,9 @@ class Agent {
 		bool has_same_type(agent_ptr other_agent) const;
 		unsigned int get_agent_id();
 		virtual action cognite(const perception* agents_personal_perception) = 0;
+		virtual void cognite_batch(const agent_ptr* agents, const perception* perceptions,
+		                           action* actions, const unsigned int quantity,
+		                           cognition_batch& scratch);
 		virtual string_ptr get_gene_description(const unsigned int gene_no);
 		unsigned int get_genes_size() const;
 		turn_counter get_birth_time() const;
@@ -63,18 +72,28 @@ class Agent {
 		void set_personal_fitness(double new_fit);
 		double get_personal_fitness() const;
 		static void set_nn_hidden_layers(const unsigned int new_nn_layers);
+		static void set_nn_hidden_width(const std::type_info* agent_type,
+		                                const unsigned int new_width);
+		static unsigned int get_nn_hidden_width(const std::type_info* agent_type);
+		static void set_incremental_networks(const bool incremental);
 
 	protected:
-		inline double scale(double val);
-		bool neuronal_network(nn_signals_ptr signals, int hidden_layer_quant);
-		bool neuronal_network(nn_signals_ptr signals);
+		bool neuronal_network(const double* signals, const unsigned int signals_size,
+		                      int hidden_layer_quant, const unsigned int hidden_layer_width);
+		bool neuronal_network(const double* signals, const unsigned int signals_size);
+		static void neuronal_networks(Agent* const* agents, const double* signals,
+		                              const unsigned int signals_size,
+		                              const unsigned int quantity, bool* decisions,
+		                              cognition_batch& scratch);
 		/** Normalizes the given input to range -1..1 per sigmoid function. */
 		inline double sigmoid(double inp) { return inp / (1.0 + abs(inp)); }
 		
 		/** Pointer to genome this agent belongs to. */
 		genome_ptr my_genome;
-		/** Chance to die per turn for tbool neuronal_network(nn_signals_ptr signalshis agent. */
+		/** Chance to die per turn for this agent. */
 		double death_chance;
+		/** Amount of turns this agent will still survive. Drawn once from death_chance. */
+		turn_counter survival_budget;
 		/** Human readable description of the agent. */
 		std::string agent_type;
 		/** Fitness of this agent. Used only for statistics and not for offspring 
@@ -90,13 +109,14 @@ class Agent {
 		turn_counter max_age;
 		
 	private:
-		nn_signals_ptr neuronal_layer(unsigned int output_layer_size, nn_signals_ptr input_signals, bool negative_genes=false);
 		void set_current_action_duration(const turn_counter new_duration);
 		
 		/** Amount of turns it will take until the agent can do a new action. */
 		turn_counter current_action_duration;
 		/** Point in time when the current action is finished. */
 		turn_counter action_finishing_time;
+		/** Handle of this agent in the population of its world. */
+		agent_handle handle;
 		/** Number of previous generations. TODO: still unused */
 		int generation;
 		/** Maximum noise which is added to every period. */
@@ -105,8 +125,26 @@ class Agent {
 		unsigned int agent_id;
 		/** Next free (unused) id for all agents. */
 		static unsigned int next_agent_id;
+		/** State of the last incremental computation of the neuronal network, created
+		    at its first use. */
+		std::unique_ptr<nn_state> network_state;
 		/** Standard quantity of hidden layers in the neuronal networks. */
 		static unsigned int hidden_layers;
+		/**
+		 * The hidden layer width of one agent type. The worlds read it while they run,
+		 * so both members are atomic.
+		 */
+		struct hidden_width_slot {
+			/** The agent type, NULL for an unused slot. */
+			std::atomic<const std::type_info*> agent_type;
+			/** Outputs per hidden layer, zero for the input width. */
+			std::atomic<unsigned int> width;
+		};
+		/** Hidden layer widths of the agent types which were given one. The used slots
+		    come first. */
+		static hidden_width_slot hidden_widths[NN_WIDTH_TYPES];
+		/** True if the neuronal networks are computed incrementally. */
+		static bool incremental_networks;
 
 
 
@@ -0,0 +1,38 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ */
+
+#include "arena.h"
+
+/**
+ * Creates an empty arena.
+ */
+Arena::Arena() {
+	reset();
+}
+
+/**
+ * Creates an empty arena. Nothing of the other arena is shared.
+ */
+Arena::Arena(const Arena& other) {
+	reset();
+}
+
+/**
+ * Empties this arena. Nothing of the other arena is shared.
+ */
+Arena& Arena::operator=(const Arena& other) {
+	reset();
+	return *this;
+}
+
+/**
+ * Starts a new memory resource for all following objects. The memory of the old one is
+ * released when its last object is destroyed.
+ */
+void Arena::reset() {
+	resource = std::make_shared<std::pmr::monotonic_buffer_resource>();
+}
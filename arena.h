@@ -0,0 +1,84 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * This file contains the class Arena, a monotonic memory pool for the objects of one
+ * generation run of a World.
+ *
+ */
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+/** Shared pointer to the memory resource of an Arena. */
+typedef std::shared_ptr<std::pmr::monotonic_buffer_resource> memory_resource_ptr;
+
+/**
+ * Allocator which takes memory from a monotonic memory resource and never gives it
+ * back. It shares the ownership of the resource, so the memory stays valid as long as
+ * any object allocated by it lives.
+ */
+template<class T> class arena_allocator {
+public:
+	typedef T value_type;
+
+	explicit arena_allocator(const memory_resource_ptr& new_resource) :
+		resource(new_resource) {}
+	template<class U> arena_allocator(const arena_allocator<U>& other) :
+		resource(other.resource) {}
+
+	/** Takes memory for n objects from the resource. */
+	T* allocate(std::size_t n) {
+		return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+	}
+	/** Does nothing, the memory is given back when the resource is destroyed. */
+	void deallocate(T* p, std::size_t n) {}
+
+	/** The memory resource. */
+	memory_resource_ptr resource;
+};
+
+template<class T, class U>
+inline bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) {
+	return a.resource == b.resource;
+}
+
+template<class T, class U>
+inline bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) {
+	return !(a == b);
+}
+
+/**
+ * A memory pool for many small objects with the same lifetime, like the agents and eggs
+ * of one generation run. Objects are created with Arena::make_shared. Their memory comes
+ * from big blocks, which are given back all at once after Arena::reset (or the
+ * destruction of the arena), as soon as the last of these objects is gone.
+ *
+ * An Arena is not thread safe. That's why copies of an Arena get their own memory: every
+ * World copy (one per thread) allocates from its own blocks.
+ */
+class Arena {
+public:
+	Arena();
+	Arena(const Arena& other);
+	Arena& operator=(const Arena& other);
+
+	void reset();
+
+	/** Creates an object of type T in this arena. */
+	template<class T, class... Args> std::shared_ptr<T> make_shared(Args&&... args) {
+		return std::allocate_shared<T>(arena_allocator<T>(resource),
+		                               std::forward<Args>(args)...);
+	}
+
+private:
+	/** The memory resource the objects of this arena come from. */
+	memory_resource_ptr resource;
+};
+
+#endif // _ARENA_H_
@@ -0,0 +1,80 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * Benchmark of EventQueue. Run it with "make bench".
+ *
+ * First the queue alone is timed with as many agents as the default Bushworldhandler
+ * scenario has. Every agent is popped and rescheduled with an action duration of one
+ * turn plus noise, like Agent::start_new_action does. Without noise all agents finish at
+ * the same time and only their ranks order them. Then whole generations of the default
+ * scenario are timed.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "agent.h"
+#include "bushworldhandler.h"
+#include "bushworld.h"
+#include "event-queue.h"
+#include "random-generator.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+/** Returns the seconds since the given point in time. */
+static double seconds_since(const bench_clock::time_point start) {
+	return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+/**
+ * Pops and reschedules agents for the given quantity of events and returns the
+ * nanoseconds per event.
+ */
+static double time_queue(const unsigned int agents, const double noise,
+                         const unsigned long events) {
+	EventQueue queue;
+	RandomGenerator random(1);
+	std::vector<turn_counter> finishing_times(agents);
+	for (unsigned index=0; index<agents; ++index) {
+		finishing_times[index] = 1.0 + random.uniform() * noise;
+		queue.push({index, 0}, finishing_times[index]);
+	}
+
+	bench_clock::time_point start = bench_clock::now();
+	for (unsigned long event=0; event<events; ++event) {
+		agent_handle agent = queue.top();
+		turn_counter& finishing_time = finishing_times[agent.index];
+		finishing_time += 1.0 + random.uniform() * noise;
+		queue.reschedule(agent, finishing_time);
+	}
+	return seconds_since(start) * 1e9 / events;
+}
+
+/**
+ * Runs the given quantity of generations of the default Bushworldhandler scenario and
+ * returns the seconds per generation.
+ */
+static double time_generations(const unsigned int generations) {
+	Bushworldhandler handler;
+	bench_clock::time_point start = bench_clock::now();
+	for (unsigned generation=0; generation<generations; ++generation)
+		handler.run_one_generation();
+	return seconds_since(start) / generations;
+}
+
+int main(int argc, char** argv) {
+	unsigned int generations = argc > 1 ? atoi(argv[1]) : 3;
+	const unsigned int agents = 160;
+	const unsigned long events = 2000000;
+
+	printf("Event queue with %u agents:\n", agents);
+	printf("%-16s %12s\n", "duration noise", "ns/event");
+	for (double noise: {0.0, Agent::get_duration_noise(), 0.3})
+		printf("%-16g %12.1f\n", noise, time_queue(agents, noise, events));
+
+	printf("Default scenario: %.3f s per generation\n", time_generations(generations));
+	return 0;
+}
@@ -0,0 +1,100 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * Benchmark of the layer kernels of NeuronalNetwork. Run it with "make bench".
+ *
+ * The networks of Fly and Wasp (one hidden layer as wide as the input, like in the
+ * default scenario) are computed for random input signals by every kernel the
+ * processor supports, and by the code made for their fixed topology, which replaces the
+ * kernels for these networks. Every kernel is compared with the scalar one: the
+ * time per decision, and how many decisions differ.
+ * All kernels multiply and add without FMA in the same order, so there must be no
+ * differences.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "fly.h"
+#include "genome.h"
+#include "neuronal-network.h"
+#include "random-generator.h"
+#include "wasp.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+/** Quantity of input vectors per network. */
+#define BENCH_VECTORS 4096
+
+/** Quantity of computations of all input vectors. */
+#define BENCH_REPETITIONS 200
+
+/**
+ * Computes the given network for all input vectors BENCH_REPETITIONS times. The
+ * decisions are written to decisions. Returns the nanoseconds per decision.
+ */
+static double time_network(const NeuronalNetwork& network, const std::vector<double>& signals,
+                           bool* decisions) {
+	bench_clock::time_point start = bench_clock::now();
+	for (unsigned repetition=0; repetition<BENCH_REPETITIONS; ++repetition)
+		network.decide_batch(signals.data(), BENCH_VECTORS, decisions);
+	double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+	return seconds * 1e9 / ((double)BENCH_VECTORS * BENCH_REPETITIONS);
+}
+
+/**
+ * Prints the times and differences of all kernels for the network of the given agent
+ * type with the given quantity of inputs.
+ */
+static void compare_kernels(const char* name, const std::type_info& agent_type,
+                            const unsigned int inputs) {
+	static const char* kernel_names[] = {"scalar", "sse2", "avx2", "avx512"};
+	RandomGenerator random(inputs);
+	Genome genome(agent_type);
+	for (unsigned gene=0; gene<inputs * (inputs + 1) + inputs + 1; ++gene)
+		genome.set_gene(gene, random.uniform());
+	NeuronalNetwork network(genome, 0, inputs, 1, 0);
+	std::vector<double> signals(BENCH_VECTORS * inputs);
+	for (auto& signal: signals)
+		signal = random.uniform() * 2.0 - 1.0;
+	std::vector<bool> scalar_decisions;
+	std::unique_ptr<bool[]> decisions(new bool[BENCH_VECTORS]);
+
+	printf("%s network (%u inputs):\n", name, inputs);
+	printf("%-8s %12s %12s %12s\n", "kernel", "ns/decision", "speedup", "differences");
+	nn_kernel chosen = NeuronalNetwork::get_kernel();
+	NeuronalNetwork::use_fixed_topologies(false);
+	double scalar_time = 0.0;
+	for (nn_kernel kernel: {NN_KERNEL_SCALAR, NN_KERNEL_SSE2, NN_KERNEL_AVX2,
+	                        NN_KERNEL_AVX512}) {
+		if (!NeuronalNetwork::set_kernel(kernel))
+			continue;
+		double time = time_network(network, signals, decisions.get());
+		unsigned int differences = 0;
+		if (kernel == NN_KERNEL_SCALAR) {
+			scalar_time = time;
+			scalar_decisions.assign(decisions.get(), decisions.get() + BENCH_VECTORS);
+		} else
+			for (unsigned n=0; n<BENCH_VECTORS; ++n)
+				differences += (decisions[n] != scalar_decisions[n]);
+		printf("%-8s %12.2f %12.2f %12u\n", kernel_names[kernel], time, scalar_time / time,
+		       differences);
+	}
+
+	NeuronalNetwork::set_kernel(chosen);
+	NeuronalNetwork::use_fixed_topologies(true);
+	double time = time_network(network, signals, decisions.get());
+	unsigned int differences = 0;
+	for (unsigned n=0; n<BENCH_VECTORS; ++n)
+		differences += (decisions[n] != scalar_decisions[n]);
+	printf("%-8s %12.2f %12.2f %12u\n", "fixed", time, scalar_time / time, differences);
+}
+
+int main() {
+	compare_kernels("Fly", typeid(Fly), FLY_NN_INPUTS);
+	compare_kernels("Wasp", typeid(Wasp), WASP_NN_INPUTS);
+	return 0;
+}
@@ -0,0 +1,78 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * Benchmark of RandomGenerator. Run it with "make bench".
+ *
+ * It is compared with the random numbers the worlds used before: the
+ * std::default_random_engine (a minstd engine) with a std::uniform_real_distribution made
+ * for every value, and integers below a bound made by multiplying such a value with the
+ * bound. Both make BENCH_NUMBERS doubles and BENCH_NUMBERS integers below 37; the time
+ * per number is printed.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include "random-generator.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+/** Quantity of random numbers of every measurement. */
+#define BENCH_NUMBERS 100000000
+
+/** The bound of the random integers. */
+#define BENCH_BOUND 37
+
+/** The random numbers of the worlds before RandomGenerator. */
+class old_generator {
+public:
+	/** Returns a random value of range 0..1. */
+	double uniform() {
+		std::uniform_real_distribution<double> distribution(0.0, 1.0);
+		return distribution(engine);
+	}
+	/** Returns a random integer of range 0..bound-1. */
+	unsigned int below(const unsigned int bound) {
+		return uniform() * (double)bound;
+	}
+
+private:
+	std::default_random_engine engine;
+};
+
+/**
+ * Makes BENCH_NUMBERS doubles and integers with the given generator and prints the
+ * nanoseconds per number. The sums are printed, too, so the numbers are really made.
+ */
+template<class generator>
+static void time_generator(const char* name, generator& random) {
+	bench_clock::time_point start = bench_clock::now();
+	// Four sums, so the additions do not wait for each other.
+	double sums[4] = {};
+	for (unsigned n=0; n<BENCH_NUMBERS; n+=4)
+		for (unsigned i=0; i<4; ++i)
+			sums[i] += random.uniform();
+	double sum = sums[0] + sums[1] + sums[2] + sums[3];
+	double uniform_time = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+	start = bench_clock::now();
+	unsigned long integer_sum = 0;
+	for (unsigned n=0; n<BENCH_NUMBERS; ++n)
+		integer_sum += random.below(BENCH_BOUND);
+	double below_time = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+	printf("%-10s %14.2f %14.2f   (sums %.6f %.6f)\n", name,
+	       uniform_time * 1e9 / BENCH_NUMBERS, below_time * 1e9 / BENCH_NUMBERS,
+	       sum / BENCH_NUMBERS, (double)integer_sum / BENCH_NUMBERS);
+}
+
+int main() {
+	printf("%-10s %14s %14s\n", "generator", "ns/uniform", "ns/below");
+	old_generator old_random;
+	time_generator("minstd", old_random);
+	RandomGenerator random;
+	time_generator("xoshiro", random);
+	return 0;
+}
@@ -6,6 +6,7 @@
  */
 
 #include "bushworld-database.h"
+#include "bushworld.h"
 #include "fly.h"
 #include "wasp.h"
 
@@ -128,23 +129,62 @@ BushworldDatabase::BushworldDatabase() {
 	db.push_back(agent_fit);
 }
 
+/** Genome summaries by type of agents. */
+typedef std::map<const std::type_info*, genome_summary> genome_summary_container;
+
+/**
+ * Returns the genome summary of the given type of agents, or an empty one if there are
+ * no such agents.
+ */
+static genome_summary summary_of(const genome_summary_container& summaries,
+                                 const std::type_info& type) {
+	auto summary_i = summaries.find(&type);
+	if (summary_i != summaries.end())
+		return summary_i->second;
+	genome_summary empty_summary;
+	empty_summary.average_fitness = 0.0;
+	return empty_summary;
+}
+
 /**
- * Takes interesting data of the actual generation from the given world my_world and puts 
- * them into the database.
+ * Returns the fitness per offspring of the given best genome, or zero if there is none.
  */
-void BushworldDatabase::collect(world_ptr my_world) {
+static double best_fitness_per_agent(const genome_ptr& best_genome) {
+	if (!best_genome || !best_genome->get_offspring_quantity())
+		return 0.0;
+	return best_genome->get_fitness() / (double)best_genome->get_offspring_quantity();
+}
+
+/**
+ * Takes interesting data of one generation from the given snapshot of a Bushworld and
+ * puts them into the database. The copied genomes of the snapshot are summarized here,
+ * so that work is done in the thread of the collection and not in the simulation.
+ */
+void BushworldDatabase::collect(world_snapshot_ptr snapshot) {
+	const bushworld_snapshot& buw_snapshot = static_cast<const bushworld_snapshot&>(*snapshot);
+	genome_summary_container summaries;
+	for (auto const& copies: snapshot->genomes) {
+		genome_summary& summary = summaries[copies.first];
+		summary = copies.second.summarize();
+		// Like World::average_genome: without offspring the last average genome is kept.
+		genome_ptr& last_average_genome = last_average_genomes[copies.first];
+		if (!copies.second.has_offspring)
+			summary.average_genome = last_average_genome;
+		else if (summary.average_genome)
+			last_average_genome = summary.average_genome;
+	}
 	for (auto const& data_set : db) {
 		genome_ptr new_gd;
 		switch (data_set->type) {
 		case AVERAGE_GENOMES: {
-			genome_ptr tmp_avg_g = my_world->average_genome(*data_set->agent_class_id);
+			genome_ptr tmp_avg_g = summary_of(summaries, *data_set->agent_class_id).average_genome;
 			if (tmp_avg_g)
 				new_gd = genome_ptr(new Genome(*tmp_avg_g));
 		}
 			break;
 			
 		case BEST_GENOMES: {
-			genome_ptr tmp_bst_g = my_world->best_genome(*data_set->agent_class_id);
+			genome_ptr tmp_bst_g = summary_of(summaries, *data_set->agent_class_id).best_genome;
 			if (tmp_bst_g)
 				new_gd = genome_ptr(new Genome(*tmp_bst_g));
 		}
@@ -156,71 +196,50 @@ void BushworldDatabase::collect(world_ptr my_world) {
 			
 		case BEST_AGENT_FIT: {
 			new_gd = genome_ptr(new Genome(*data_set->agent_class_id, 2, 0.0));
-			genome_ptr fly_best_genome = my_world->best_genome(typeid(Fly));
-			double best_fit_pa;
-			if (!fly_best_genome || !fly_best_genome->get_offspring_quantity())
-				best_fit_pa = 0.0;
-			else
-				best_fit_pa = fly_best_genome->get_fitness() /
-					(double)fly_best_genome->get_offspring_quantity();
-			new_gd->set_gene(0, best_fit_pa);
-				
-			genome_ptr wasp_best_genome = my_world->best_genome(typeid(Wasp));
-			if (!wasp_best_genome || !wasp_best_genome->get_offspring_quantity())
-				best_fit_pa = 0.0;
-			else
-				best_fit_pa = wasp_best_genome->get_fitness() /
-					(double)wasp_best_genome->get_offspring_quantity();
-			new_gd->set_gene(1, best_fit_pa);
-				
+			new_gd->set_gene(0, best_fitness_per_agent(summary_of(summaries, typeid(Fly))
+			                                           .best_genome));
+			new_gd->set_gene(1, best_fitness_per_agent(summary_of(summaries, typeid(Wasp))
+			                                           .best_genome));
 		}
 			break;
 			
 		case DWELL_TIME: {
 			new_gd = genome_ptr(new Genome(*data_set->agent_class_id, 2, 0.0));
-			bushworld_ptr my_buw = std::static_pointer_cast<Bushworld>(my_world);
-			turn_counter time_per_branch = my_buw->get_average_branch_time(false);
-			new_gd->set_gene(0, time_per_branch);
-			time_per_branch = my_buw->get_average_branch_time(true);
-			new_gd->set_gene(1, time_per_branch);
+			new_gd->set_gene(0, buw_snapshot.fly_branch_time);
+			new_gd->set_gene(1, buw_snapshot.wasp_branch_time);
 		}
 			break;
 			
 		case AVG_JUMPS: {
 			new_gd = genome_ptr(new Genome(*data_set->agent_class_id, 2, 0.0));
-			bushworld_ptr my_buw = std::static_pointer_cast<Bushworld>(my_world);
-			double cl_jumps = my_buw->get_average_cluster_jumps(&typeid(Fly));
-			new_gd->set_gene(0, cl_jumps);
-			cl_jumps = my_buw->get_average_cluster_jumps(&typeid(Wasp));
-			new_gd->set_gene(1, cl_jumps);
+			new_gd->set_gene(0, buw_snapshot.fly_cluster_jumps);
+			new_gd->set_gene(1, buw_snapshot.wasp_cluster_jumps);
 		}
 			break;
 			
 		case OVERALL_OFFSPRING: {
 			new_gd = genome_ptr(new Genome(*data_set->agent_class_id, 2, 0.1));
-			new_gd->set_gene(0, my_world->get_average_fitness(&typeid(Fly)));
-			new_gd->set_gene(1, my_world->get_average_fitness(&typeid(Wasp)));
+			new_gd->set_gene(0, summary_of(summaries, typeid(Fly)).average_fitness);
+			new_gd->set_gene(1, summary_of(summaries, typeid(Wasp)).average_fitness);
 		}
 			break;
 			
 		case BEST_AGENT_JUMPS: {
 			new_gd = genome_ptr(new Genome(*data_set->agent_class_id, 2, 0.1));
-			bushworld_ptr my_buw = std::static_pointer_cast<Bushworld>(my_world);
-			new_gd->set_gene(0, my_buw->get_best_insect_jumps(&typeid(Fly)));
-			new_gd->set_gene(1, my_buw->get_best_insect_jumps(&typeid(Wasp)));
+			new_gd->set_gene(0, buw_snapshot.best_fly_jumps);
+			new_gd->set_gene(1, buw_snapshot.best_wasp_jumps);
 		}
 			break;
 			
 		case BEST_AGENT_DWELL_TIME: {
 			new_gd = genome_ptr(new Genome(*data_set->agent_class_id, 2, 0.1));
-			bushworld_ptr my_buw = std::static_pointer_cast<Bushworld>(my_world);
-			new_gd->set_gene(0, my_buw->get_best_insect_avg_branch_time(&typeid(Fly)));
-			new_gd->set_gene(1, my_buw->get_best_insect_avg_branch_time(&typeid(Wasp)));
+			new_gd->set_gene(0, buw_snapshot.best_fly_branch_time);
+			new_gd->set_gene(1, buw_snapshot.best_wasp_branch_time);
 		}
 			break;
 			
 		case INTERPRETED_BEST_GENOME: {
-			genome_ptr best_g = my_world->best_genome(*data_set->agent_class_id);
+			genome_ptr best_g = summary_of(summaries, *data_set->agent_class_id).best_genome;
 			if (best_g) {
 				new_gd = genome_ptr(new Genome(*best_g->get_type_id(), 1));
 				double divider = best_g->get_gene(0) * 10;
@@ -234,6 +253,7 @@ void BushworldDatabase::collect(world_ptr my_world) {
 		}
 
 		if (new_gd) {
+			std::lock_guard<std::mutex> lock(data_set->mutex);
 			for (unsigned i=0; i<new_gd->size(); ++i) {
 				double gene_val = new_gd->get_gene(i);
 				if (gene_val > data_set->highest_value)
@@ -36,12 +36,13 @@ class BushworldDatabase: public SimulationDatabase {
 	
 public:
 	BushworldDatabase();
-	void collect(world_ptr my_world);
+	void collect(world_snapshot_ptr snapshot);
 
 protected:
 
 private:
-
+	/** The last average genome of every type of agents (see World::average_genome). */
+	std::map<const std::type_info*, genome_ptr> last_average_genomes;
 };
 
 #endif // _BUSHWORLD_DATABASE_H_
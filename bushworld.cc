@@ -35,7 +35,31 @@ Bushworld::Bushworld(const unsigned int branch_quantity, const unsigned int frui
 void Bushworld::recreate_world() {
 	set_bush_size(get_branch_quantity(), get_fruits_per_branch());
 	genepool = genepool_copy();
-	population.clear();
+	clear_population();
+}
+
+/**
+ * Loads the generation of the master world (see World::load_generation) and empties the
+ * bush. The bush is only built anew if the master has another size, otherwise all eggs
+ * are removed and the fruits keep their memory.
+ */
+void Bushworld::load_generation(const World& master) {
+	World::load_generation(master);
+	const Bushworld& master_bushworld = static_cast<const Bushworld&>(master);
+	insects_death_chance = master_bushworld.insects_death_chance;
+	parasitoid_max_age = master_bushworld.parasitoid_max_age;
+	host_max_age = master_bushworld.host_max_age;
+	parasitoid_beginning_time = master_bushworld.parasitoid_beginning_time;
+
+	if (get_branch_quantity() != master_bushworld.get_branch_quantity() ||
+	    get_fruits_per_branch() != master_bushworld.get_fruits_per_branch()) {
+		set_bush_size(master_bushworld.get_branch_quantity(),
+		              master_bushworld.get_fruits_per_branch());
+		return;
+	}
+	for (auto const& bush_branch: bush)
+		for (auto& bush_fruit: *bush_branch)
+			bush_fruit.clear();
 }
 
 /**
@@ -119,12 +143,8 @@ void Bushworld::set_bush_size(unsigned int new_branch_quantity, unsigned int fru
 	}
 
 	// The living insects must have new places because of the different world size.
-	agent_container::iterator agent_i = population.begin();
-	while (agent_i != population.end()) {
-		insect_ptr cooper = std::dynamic_pointer_cast<Insect>(*agent_i);
-		place_insect_randomly(cooper);
-		++agent_i;
-	}
+	for (auto const& agent: population)
+		place_insect_randomly(static_cast<Insect*>(agent.get()));
 }
 
 /**
@@ -153,29 +173,40 @@ void Bushworld::set_fruits_per_branch(unsigned int fruits_per_branch) {
  * here?).
  */
 void Bushworld::make_perception(agent_ptr agent_cooper, perception* cooper_sees) {
-	insect_ptr cooper = std::dynamic_pointer_cast<Insect>(agent_cooper);
-	bush_position c_pos = cooper->get_position();
+	const Insect* cooper = static_cast<const Insect*>(agent_cooper.get());
+	make_perception(*cooper->get_columns(), cooper->get_row(), agent_cooper->get_genome_ptr(),
+	                cooper_sees);
+}
+
+/**
+ * Creates the perception of the insect in the given row of the given columns, which has
+ * the given genome.
+ */
+void Bushworld::make_perception(const insect_columns& cols, const unsigned int row,
+                                const genome_ptr& genome, perception* cooper_sees) {
+	const unsigned int c_branch = cols.branch[row];
+	const unsigned int c_fruit = cols.fruit[row];
 	
 	cooper_sees->competition_pressure = 1.0; // TODO?
-	BUG_CHECK(c_pos.branch >= bush.size(), "Insect sits on branch " << c_pos.branch << 
+	BUG_CHECK(c_branch >= bush.size(), "Insect sits on branch " << c_branch << 
 	          ", but there are only " << bush.size() << " branches in the bush.");
-	cooper_sees->fruits_in_branch = bush.at(c_pos.branch)->size();
-	BUG_CHECK(cooper_sees->fruits_in_branch <= c_pos.fruit, "Agent sits on fruit " << 
-	          c_pos.fruit << ", but there are only " << cooper_sees->fruits_in_branch << 
+	cooper_sees->fruits_in_branch = bush[c_branch]->size();
+	BUG_CHECK(cooper_sees->fruits_in_branch <= c_fruit, "Agent sits on fruit " << 
+	          c_fruit << ", but there are only " << cooper_sees->fruits_in_branch << 
 	          " fruits here.");
-	cooper_sees->fruit_free = bush.at(c_pos.branch)->at(c_pos.fruit).size() == 0;
-	cooper_sees->fly_eggs_in_fruit = bush.at(c_pos.branch)->at(c_pos.fruit).size();
+	const fruit& c_fruit_eggs = (*bush[c_branch])[c_fruit];
+	cooper_sees->fruit_free = c_fruit_eggs.size() == 0;
+	cooper_sees->fly_eggs_in_fruit = c_fruit_eggs.size();
 	cooper_sees->wasp_eggs_in_fruit = 0;
 	cooper_sees->foreign_eggs_in_fruit = 0;
 	cooper_sees->own_eggs_in_fruit = 0;
 	cooper_sees->current_time = turn;
 
 	// The insects looks at every egg here.
-	for (auto const& fly_egg: bush.at(c_pos.branch)->at(c_pos.fruit)) {
+	for (auto const& fly_egg: c_fruit_eggs) {
 		if (fly_egg->wasp_genome)
 			++cooper_sees->wasp_eggs_in_fruit;
-		if (fly_egg->fly_genome != agent_cooper->get_genome_ptr() && 
-		    fly_egg->wasp_genome != agent_cooper->get_genome_ptr())
+		if (fly_egg->fly_genome != genome && fly_egg->wasp_genome != genome)
 			++cooper_sees->foreign_eggs_in_fruit;
 		else
 			++cooper_sees->own_eggs_in_fruit;			
@@ -189,10 +220,7 @@ unsigned int Bushworld::choose_fruit(unsigned int branch_no) const {
 	BUG_CHECK(branch_no>=bush.size(), "Branch number too high: " << branch_no);
 	BUG_CHECK(!bush.size(), "Empty bush.");
 	BUG_CHECK(!bush.at(branch_no)->size(), "Empty branch.");
-	unsigned int ret = randone() * (double)bush.at(branch_no)->size();
-	// This is a quick dirty hack, but this situation happens very rarely.
-	if (ret == bush.at(branch_no)->size())
-		--ret;
+	unsigned int ret = environment_randbelow(bush.at(branch_no)->size());
 	BUG_CHECK(ret < 0 || ret >= bush.at(branch_no)->size(), "Fruit " << ret << 
 		" chosen, but that's impossible.");
 	return ret;
@@ -252,8 +280,19 @@ turn_counter Bushworld::get_action_duration(const action* acting_action) {
  */
 void Bushworld::execute_action(agent_ptr agent_cooper, action coopers_action) {
 	BUG_CHECK(!agent_cooper, "Empty agent pointer.")
-	insect_ptr cooper = std::dynamic_pointer_cast<Insect>(agent_cooper);
-	bush_position c_pos = cooper->get_position();
+	Insect* cooper = static_cast<Insect*>(agent_cooper.get());
+	execute_action(cooper, *cooper->get_columns(), cooper->get_row(), cooper->is_parasitoid(),
+	               coopers_action);
+}
+
+/**
+ * Executes the action of the given insect, whose state is in the given row of the given
+ * columns.
+ */
+void Bushworld::execute_action(Insect* cooper, insect_columns& cols, const unsigned int row,
+                               const bool parasitoid, const action& coopers_action) {
+	const unsigned int c_branch = cols.branch[row];
+	const unsigned int c_fruit = cols.fruit[row];
 	debug_msg("Folgende Action beginnt um " << turn << " und soll " << 
 	          get_action_duration(&coopers_action) << " dauern.");
 	cooper->starts_to_act(get_action_duration(&coopers_action), turn);
@@ -262,48 +301,50 @@ void Bushworld::execute_action(agent_ptr agent_cooper, action coopers_action) {
 		case LAY_EGG: {
 			debug_msg("Agents LAYs EGG");
 
-			if (!cooper->is_parasitoid()) {
-				if (bush.at(c_pos.branch)->at(c_pos.fruit).size()) { // if there is already a fly egg.
+			fruit& c_fruit_eggs = (*bush[c_branch])[c_fruit];
+			if (!parasitoid) {
+				if (c_fruit_eggs.size()) { // if there is already a fly egg.
 					debug_msg("Bug? There is already a fly egg!");
 					break; // there is no chance to lay an egg.
 				}
-				fly_egg_ptr new_fly_egg = fly_egg_ptr(new fly_egg);
+				fly_egg_ptr new_fly_egg = arena.make_shared<fly_egg>();
 				new_fly_egg->wasp_genome = genome_ptr();
 				new_fly_egg->fly_genome = cooper->get_genome_ptr();
-				new_fly_egg->laying_fly = cooper;
-				bush.at(c_pos.branch)->at(c_pos.fruit).push_back(new_fly_egg);
+				new_fly_egg->laying_fly = cooper->get_handle();
+				c_fruit_eggs.push_back(new_fly_egg);
 			} else {
-				if (bush.at(c_pos.branch)->at(c_pos.fruit).size() < 1) { // if there is no fly egg.
+				if (c_fruit_eggs.size() < 1) { // if there is no fly egg.
 					debug_msg("Bug? There is no a fly egg, but wasp wants to lay an egg!");
 					break; // there is no chance to lay an egg.
 				}
-				fly_egg_ptr old_fly_egg = bush.at(c_pos.branch)->at(c_pos.fruit).front();
+				fly_egg_ptr old_fly_egg = c_fruit_eggs.front();
 				if (old_fly_egg->wasp_genome) {
 					debug_msg("Bug? There is already a wasp egg in the fly egg, but wasp "
 					          << "wants to lay another.");
 					break; // there is no chance to lay an egg.
 				}
 				old_fly_egg->wasp_genome = cooper->get_genome_ptr();
-				old_fly_egg->laying_wasp = cooper;
+				old_fly_egg->laying_wasp = cooper->get_handle();
 			}
 		}
 		break;
 		
 		case GO_TO_FRUIT: {
-			cooper->set_fruit_pos(choose_fruit(c_pos.branch));
-			debug_msg("Agents GOES TO FRUIT " << cooper->get_position().fruit);
+			cols.fruit[row] = choose_fruit(c_branch);
+			debug_msg("Agents GOES TO FRUIT " << cols.fruit[row]);
 		}
 		break;
 		
 		case GO_TO_BRANCH_WEST: {
-			int coopers_new_branch = c_pos.branch + get_flying_distance(coopers_action.intensity);
+			int coopers_new_branch = c_branch + get_flying_distance(coopers_action.intensity);
 			coopers_new_branch %= bush.size();
-			cooper->set_branch_pos(coopers_new_branch);
-			if (cooper->is_parasitoid()) {
-				wasp_branch_time += turn - cooper->get_last_branch_arrival_time();
+			BUG_CHECK(coopers_new_branch<0, "Negative branch position.");
+			cols.branch[row] = coopers_new_branch;
+			if (parasitoid) {
+				wasp_branch_time += turn - cols.last_branch_arrival_time[row];
 				++wasp_branch_jumps;
 			} else {
-				fly_branch_time += turn - cooper->get_last_branch_arrival_time();
+				fly_branch_time += turn - cols.last_branch_arrival_time[row];
 				++fly_branch_jumps;
 			}
 			//cooper->set_last_branch_arrival_time(cooper->get_action_finishing_time());
@@ -316,14 +357,15 @@ void Bushworld::execute_action(agent_ptr agent_cooper, action coopers_action) {
 		break;
 
 		case GO_TO_BRANCH_EAST: {
-			int coopers_new_branch = c_pos.branch - get_flying_distance(coopers_action.intensity);
+			int coopers_new_branch = c_branch - get_flying_distance(coopers_action.intensity);
 			coopers_new_branch %= bush.size();
-			cooper->set_branch_pos(coopers_new_branch);
-			if (cooper->is_parasitoid()) {
-				wasp_branch_time += turn - cooper->get_last_branch_arrival_time();
+			BUG_CHECK(coopers_new_branch<0, "Negative branch position.");
+			cols.branch[row] = coopers_new_branch;
+			if (parasitoid) {
+				wasp_branch_time += turn - cols.last_branch_arrival_time[row];
 				++wasp_branch_jumps;
 			} else {
-				fly_branch_time += turn - cooper->get_last_branch_arrival_time();
+				fly_branch_time += turn - cols.last_branch_arrival_time[row];
 				++fly_branch_jumps;
 			}
 			//cooper->set_last_branch_arrival_time(cooper->get_action_finishing_time());
@@ -457,13 +499,14 @@ double Bushworld::calculate_fitness() {
 				fly_egg_ptr first_fly_egg = fruit.front();
 				
 				BUG_CHECK(!first_fly_egg->fly_genome, "Fly egg without fly genome!");
-				BUG_CHECK(!first_fly_egg->laying_fly, "Fly pointer missing.");
+				BUG_CHECK(!population.holds(first_fly_egg->laying_fly), "Fly handle invalid.");
 				
 				genome_ptr surviving_genome;
-				insect_ptr laying_insect;
+				agent_handle laying_insect;
 				if (first_fly_egg->wasp_genome) {
 					surviving_genome = first_fly_egg->wasp_genome;
-					BUG_CHECK(!first_fly_egg->laying_wasp, "Wasp pointer missing.");
+					BUG_CHECK(!population.holds(first_fly_egg->laying_wasp), 
+					          "Wasp handle invalid.");
 					laying_insect = first_fly_egg->laying_wasp;
 				} else {
 					surviving_genome = first_fly_egg->fly_genome;
@@ -483,48 +526,87 @@ double Bushworld::calculate_fitness() {
 	return best_fitness;
 }
 
-void Bushworld::collect_multithread_statistics(world_ptr tmp_world) {
-	bushworld_ptr tmp_bushworld = std::dynamic_pointer_cast<Bushworld>(tmp_world);
+/**
+ * Returns the statistics of the generation this world has just computed which
+ * Bushworld::collect_multithread_statistics adds up.
+ */
+reiteration_statistics_ptr Bushworld::take_reiteration_statistics() {
+	std::unique_ptr<bushworld_reiteration_statistics> statistics(
+		new bushworld_reiteration_statistics);
+	statistics->fly_branch_jumps = get_branch_jumps(false);
+	statistics->wasp_branch_jumps = get_branch_jumps(true);
+	statistics->fly_branch_time = get_branch_time(false);
+	statistics->wasp_branch_time = get_branch_time(true);
+	statistics->best_fly_fitness = get_best_per_agent_fitness(typeid(Fly));
+	statistics->best_wasp_fitness = get_best_per_agent_fitness(typeid(Wasp));
+	statistics->best_fly_jumps = get_best_insect_jumps(&typeid(Fly));
+	statistics->best_wasp_jumps = get_best_insect_jumps(&typeid(Wasp));
+	statistics->best_fly_branch_time = get_best_insect_avg_branch_time(&typeid(Fly));
+	statistics->best_wasp_branch_time = get_best_insect_avg_branch_time(&typeid(Wasp));
+	return statistics;
+}
+
+void Bushworld::collect_multithread_statistics(const reiteration_statistics& statistics) {
+	const bushworld_reiteration_statistics& tmp_statistics =
+		static_cast<const bushworld_reiteration_statistics&>(statistics);
 
 	// Average cluster jumps.
-	add_branch_jumps(true, tmp_bushworld->get_branch_jumps(true));
-	add_branch_jumps(false, tmp_bushworld->get_branch_jumps(false));
+	add_branch_jumps(true, tmp_statistics.wasp_branch_jumps);
+	add_branch_jumps(false, tmp_statistics.fly_branch_jumps);
 
 	// Average time per cluster and insect.
-	add_branch_time(true, tmp_bushworld->get_branch_time(true));
-	add_branch_time(false, tmp_bushworld->get_branch_time(false));
+	add_branch_time(true, tmp_statistics.wasp_branch_time);
+	add_branch_time(false, tmp_statistics.fly_branch_time);
 
 	// Fitness value of the best wasp.
-	double best_per_agent_fitness = tmp_world->get_best_per_agent_fitness(typeid(Wasp));
+	double best_per_agent_fitness = tmp_statistics.best_wasp_fitness;
 	best_per_agent_fitness += get_best_per_agent_fitness(typeid(Wasp));
 	set_best_per_agent_fitness(typeid(Wasp), best_per_agent_fitness);
 
 	// Fitness value of the best fly.
-	best_per_agent_fitness = tmp_world->get_best_per_agent_fitness(typeid(Fly));
+	best_per_agent_fitness = tmp_statistics.best_fly_fitness;
 	best_per_agent_fitness += get_best_per_agent_fitness(typeid(Fly));
 	set_best_per_agent_fitness(typeid(Fly), best_per_agent_fitness);
 
 	// Amount of cluster jumps of the best wasp.
-	double best_jumps = tmp_bushworld->get_best_insect_jumps(&typeid(Wasp));
+	double best_jumps = tmp_statistics.best_wasp_jumps;
 	best_jumps += get_best_insect_jumps(&typeid(Wasp));
 	set_best_insect_jumps(&typeid(Wasp), best_jumps);
 
 	// Amount of cluster jumps of the best fly.
-	best_jumps = tmp_bushworld->get_best_insect_jumps(&typeid(Fly));
+	best_jumps = tmp_statistics.best_fly_jumps;
 	best_jumps += get_best_insect_jumps(&typeid(Fly));
 	set_best_insect_jumps(&typeid(Fly), best_jumps);
 
 	// Average cluster time of best wasp.
-	double best_bt = tmp_bushworld->get_best_insect_avg_branch_time(&typeid(Wasp));
+	double best_bt = tmp_statistics.best_wasp_branch_time;
 	best_bt += get_best_insect_avg_branch_time(&typeid(Wasp));
 	set_best_insect_avg_branch_time(&typeid(Wasp), best_bt);
 
 	// Average cluster time of best fly.
-	best_bt = tmp_bushworld->get_best_insect_avg_branch_time(&typeid(Fly));
+	best_bt = tmp_statistics.best_fly_branch_time;
 	best_bt += get_best_insect_avg_branch_time(&typeid(Fly));
 	set_best_insect_avg_branch_time(&typeid(Fly), best_bt);
 }
 
+/**
+ * Returns the statistics of the current generation with the counters of the bush (see
+ * World::make_snapshot).
+ */
+world_snapshot_ptr Bushworld::make_snapshot() {
+	std::shared_ptr<bushworld_snapshot> snapshot(new bushworld_snapshot);
+	copy_genomes(*snapshot);
+	snapshot->fly_branch_time = get_average_branch_time(false);
+	snapshot->wasp_branch_time = get_average_branch_time(true);
+	snapshot->fly_cluster_jumps = get_average_cluster_jumps(&typeid(Fly));
+	snapshot->wasp_cluster_jumps = get_average_cluster_jumps(&typeid(Wasp));
+	snapshot->best_fly_jumps = get_best_insect_jumps(&typeid(Fly));
+	snapshot->best_wasp_jumps = get_best_insect_jumps(&typeid(Wasp));
+	snapshot->best_fly_branch_time = get_best_insect_avg_branch_time(&typeid(Fly));
+	snapshot->best_wasp_branch_time = get_best_insect_avg_branch_time(&typeid(Wasp));
+	return snapshot;
+}
+
 void Bushworld::finish_multithread_statistics(unsigned int world_runs) {
 	double best_pa_fitness = get_best_per_agent_fitness(typeid(Wasp)) / (double)world_runs;
 	set_best_per_agent_fitness(typeid(Wasp), best_pa_fitness);
@@ -581,10 +663,10 @@ agent_ptr Bushworld::create_agent(genome_ptr agent_genome) {
 
 	insect_ptr new_agent;
 	if (agent_genome->agents_type_equals(typeid(Wasp))) {
-		new_agent = wasp_ptr(new Wasp(agent_genome));
+		new_agent = arena.make_shared<Wasp>(agent_genome);
 		new_agent->set_max_age(parasitoid_max_age);
 	} else if (agent_genome->agents_type_equals(typeid(Fly))) {
-		new_agent = fly_ptr(new Fly(agent_genome));
+		new_agent = arena.make_shared<Fly>(agent_genome);
 		new_agent->set_max_age(host_max_age);
 	} else {
 		BUG_CHECK(true, "Bug: Unknown genome from agent " << 
@@ -592,19 +674,46 @@ agent_ptr Bushworld::create_agent(genome_ptr agent_genome) {
 	}
 	new_agent->set_death_chance(insects_death_chance);
 
-	place_insect_randomly(new_agent);
-
 	return new_agent;
 }
 
+/**
+ * Lets the given insect cognite. A Bushworld only contains flys and wasps, so this
+ * calls Fly::cognite or Wasp::cognite directly instead of the virtual Agent::cognite
+ * (see World::run_static).
+ */
+action Bushworld::dispatch_cognite(const agent_ptr& cooper, const perception* cooper_sees) {
+	Insect* insect = static_cast<Insect*>(cooper.get());
+	if (insect->is_parasitoid())
+		return static_cast<Wasp*>(insect)->Wasp::cognite(cooper_sees);
+	return static_cast<Fly*>(insect)->Fly::cognite(cooper_sees);
+}
+
+/**
+ * Puts the new insect into the InsectStore and on a randomly chosen fruit.
+ */
+void Bushworld::agent_added(const agent_ptr& new_agent) {
+	Insect* new_insect = static_cast<Insect*>(new_agent.get());
+	new_insect->join_store(&insects);
+	place_insect_randomly(new_insect);
+}
+
+/**
+ * Removes all insects from the population and from the InsectStore.
+ */
+void Bushworld::clear_population() {
+	World::clear_population();
+	insects.clear();
+}
+
 /**
  * Puts the insect on a randomly chosen fruit in the Bushworld.
  */
-void Bushworld::place_insect_randomly(insect_ptr lost_insect) {
+void Bushworld::place_insect_randomly(Insect* lost_insect) {
 	BUG_CHECK(!lost_insect, "No insect.");
-	unsigned int new_branch_pos = (double)bush.size() * randone();
+	unsigned int new_branch_pos = environment_randbelow(bush.size());
 	BUG_CHECK(new_branch_pos >= bush.size() || bush.size() == 0, "Wrong branch");
-	unsigned int new_fruit_pos = (double)bush.at(new_branch_pos)->size() * randone();
+	unsigned int new_fruit_pos = environment_randbelow(bush.at(new_branch_pos)->size());
 	BUG_CHECK(new_fruit_pos >= bush.at(new_branch_pos)->size() || 
 	          bush.at(new_branch_pos)->size() == 0, "Wrong fruit.");
 	lost_insect->set_position(new_branch_pos, new_fruit_pos);
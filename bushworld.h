@@ -12,6 +12,7 @@
 #include <map>
 
 #include "world.h"
+#include "insect-store.h"
 #include "debug_macros.h"
 
 class Genome;
@@ -37,8 +38,8 @@ typedef std::shared_ptr<Insect> insect_ptr;
 struct fly_egg {
 	genome_ptr fly_genome;
 	genome_ptr wasp_genome;
-	insect_ptr laying_fly;
-	insect_ptr laying_wasp;
+	agent_handle laying_fly;
+	agent_handle laying_wasp;
 };
 
 typedef std::shared_ptr<fly_egg> fly_egg_ptr;
@@ -58,6 +59,46 @@ typedef std::vector<branch_ptr> plant;
 class Bushworld;
 typedef std::shared_ptr<Bushworld> bushworld_ptr;
 
+/**
+ * The statistics of one generation of a Bushworld (see Bushworld::make_snapshot).
+ */
+struct bushworld_snapshot : world_snapshot {
+	/** Average time per cluster of the flies and the wasps. */
+	turn_counter fly_branch_time;
+	turn_counter wasp_branch_time;
+	/** Average quantity of cluster changes per fly and per wasp. */
+	double fly_cluster_jumps;
+	double wasp_cluster_jumps;
+	/** Quantity of cluster changes of the fittest fly and the fittest wasp. */
+	double best_fly_jumps;
+	double best_wasp_jumps;
+	/** Average time per cluster of the fittest fly and the fittest wasp. */
+	turn_counter best_fly_branch_time;
+	turn_counter best_wasp_branch_time;
+};
+
+/**
+ * The statistics of one reiteration of a Bushworld generation (see
+ * Bushworld::take_reiteration_statistics).
+ */
+struct bushworld_reiteration_statistics : reiteration_statistics {
+	/** Sums of the cluster changes of all flies and all wasps. */
+	unsigned int fly_branch_jumps;
+	unsigned int wasp_branch_jumps;
+	/** Sums of the times per cluster of all flies and all wasps. */
+	double fly_branch_time;
+	double wasp_branch_time;
+	/** Fitness of the fittest fly and the fittest wasp. */
+	double best_fly_fitness;
+	double best_wasp_fitness;
+	/** Quantity of cluster changes of the fittest fly and the fittest wasp. */
+	double best_fly_jumps;
+	double best_wasp_jumps;
+	/** Average time per cluster of the fittest fly and the fittest wasp. */
+	double best_fly_branch_time;
+	double best_wasp_branch_time;
+};
+
 /** All the percepted information an insect gets. */
 struct perception {
 	unsigned int fruits_in_branch; // quantity of fruits on the current branch
@@ -94,6 +135,8 @@ struct action {
  * branches (containers/clusters of fruits).
  */
 class Bushworld final : public World {
+	/** World::run_static calls the protected methods of this class directly. */
+	friend class World;
 public:
 	Bushworld(const unsigned int branches=10, const unsigned int fruits_per_branch=10);
 	void set_parasitoid_max_age(turn_counter para_max_age);
@@ -111,22 +154,28 @@ public:
 	void reset_statistics() override;
 	double calculate_fitness();
 	void recreate_world() override;
+	void load_generation(const World& master) override;
 	void add_branch_jumps(const bool for_parasitoid, unsigned int new_jumps);
 	void add_branch_time(const bool for_parasitoid, double new_time);
 	unsigned int get_branch_jumps(const bool for_parasitoid);
 	double get_branch_time(const bool for_parasitoid);
-	void collect_multithread_statistics(world_ptr tmp_world) override;
+	reiteration_statistics_ptr take_reiteration_statistics() override;
+	void collect_multithread_statistics(const reiteration_statistics& statistics) override;
 	void finish_multithread_statistics(unsigned int world_runs) override;
 	double get_best_insect_jumps(const std::type_info* ins_type);
 	void set_best_insect_jumps(const std::type_info* ins_type, double jumps);
 	double get_best_insect_avg_branch_time(const std::type_info* ins_type);
 	void set_best_insect_avg_branch_time(const std::type_info* ins_type, double avg_b_t);
 	void set_nn_layers(unsigned int new_nn_layers);
+	void clear_population() override;
+	world_snapshot_ptr make_snapshot() override;
 	
 protected:
 	void make_perception(agent_ptr cooper, perception* cooper_sees);
 	void execute_action(agent_ptr cooper, action coopers_action);
 	agent_ptr create_agent(genome_ptr agent_genome);
+	void agent_added(const agent_ptr& new_agent) override;
+	action dispatch_cognite(const agent_ptr& cooper, const perception* cooper_sees);
 	/** Average time flys stay on branches per life. */
 	turn_counter fly_branch_time;
 	/** Average number of fly branch changes per life. */
@@ -147,12 +196,18 @@ private:
 	double insects_death_chance;
 	/** The data structure which contains all branches (and fruits). */
 	plant bush;
+	/** The often used state of all insects. */
+	InsectStore insects;
+	void make_perception(const insect_columns& cols, const unsigned int row, 
+	                     const genome_ptr& genome, perception* cooper_sees);
+	void execute_action(Insect* cooper, insect_columns& cols, const unsigned int row, 
+	                    const bool parasitoid, const action& coopers_action);
 	/** Returns the randomly chosen index number of one fruit. */
 	unsigned int choose_fruit(unsigned int branch_no) const;
 	turn_counter get_action_duration(const action* acting_action);
 	/** Point in time when wasps can start to act. */
 	turn_counter parasitoid_beginning_time;
-	void place_insect_randomly(insect_ptr lost_insect);
+	void place_insect_randomly(Insect* lost_insect);
 	/** Amount of moves between clusters of the best wasp. */
 	double best_wasp_cluster_jumps;
 	/** Amount of moves between clusters of the best fly. */
@@ -12,8 +12,13 @@
 #include "fly.h"
 #include "wasp.h"
 #include "bushworld-database.h"
+#include "neuronal-network.h"
+#include "task-pool.h"
 
-Bushworldhandler::Bushworldhandler() {
+Bushworldhandler::Bushworldhandler() :
+	fitness_variance_report(false),
+	worker_report(false)
+{
 	wasp_quant_param_id = create_new_parameter(80, 0, 501, &wasp_dscr);
 	fly_quant_param_id = create_new_parameter(80, 1, 501, &fly_dscr);
 	branch_quant_param_id = create_new_parameter(200, 1, 401, &branch_dscr);
@@ -25,6 +30,23 @@ Bushworldhandler::Bushworldhandler() {
 	parallel_worlds_id = create_new_parameter(4, 1, 201, &par_worlds_dscr);
 	recombi_id = create_new_parameter(1, 0, 2, &recombi_dscr);
 	hiddenlayers_id = create_new_parameter(1, 0, 9, &hiddenlayers_dscr);
+	fly_hidden_width_id = create_new_parameter(0, 0, NN_MAX_SIGNALS + 1,
+	                                           &fly_hidden_width_dscr);
+	wasp_hidden_width_id = create_new_parameter(0, 0, NN_MAX_SIGNALS + 1,
+	                                            &wasp_hidden_width_dscr);
+	cognition_window_id = create_new_parameter(0.0, 0.0, 3.31, &cognition_window_dscr, 0.01);
+	nn_precision_id = create_new_parameter(NN_PRECISION_DOUBLE, NN_PRECISION_DOUBLE,
+	                                       NN_PRECISION_INT8 + 1, &nn_precision_dscr);
+	nn_validation_id = create_new_parameter(0, 0, 2, &nn_validation_dscr);
+	decision_cache_id = create_new_parameter(0.0, 0.0, 0.51, &decision_cache_dscr, 0.01);
+	incremental_nn_id = create_new_parameter(0, 0, 2, &incremental_nn_dscr);
+	nn_jit_id = create_new_parameter(0, 0, 2, &nn_jit_dscr);
+	variance_reduction_id = create_new_parameter(VR_NONE, VR_NONE,
+	                                             (VR_COMMON | VR_ANTITHETIC) + 1,
+	                                             &variance_reduction_dscr);
+	fitness_variance_report_id = create_new_parameter(0, 0, 2, &fitness_variance_report_dscr);
+	pin_threads_id = create_new_parameter(0, 0, 2, &pin_threads_dscr);
+	worker_report_id = create_new_parameter(0, 0, 2, &worker_report_dscr);
 	
 	init_world();
 }
@@ -60,6 +82,33 @@ void Bushworldhandler::parameter_changed_signal(world_parameter_container::itera
 		my_bushworld->set_recombination(wp_i->second->val);
 	else if (param_id == hiddenlayers_id)
 		Agent::set_nn_hidden_layers(wp_i->second->val);
+	else if (param_id == fly_hidden_width_id)
+		Agent::set_nn_hidden_width(&typeid(Fly), wp_i->second->val);
+	else if (param_id == wasp_hidden_width_id)
+		Agent::set_nn_hidden_width(&typeid(Wasp), wp_i->second->val);
+	else if (param_id == cognition_window_id)
+		my_bushworld->set_cognition_window(wp_i->second->val);
+	else if (param_id == nn_precision_id)
+		NeuronalNetwork::set_precision((nn_precision)wp_i->second->val);
+	else if (param_id == nn_validation_id)
+		NeuronalNetwork::set_validation(wp_i->second->val);
+	else if (param_id == decision_cache_id)
+		NeuronalNetwork::set_cache_step(wp_i->second->val);
+	else if (param_id == incremental_nn_id)
+		Agent::set_incremental_networks(wp_i->second->val);
+	else if (param_id == nn_jit_id) {
+		if (!NeuronalNetwork::set_jit(wp_i->second->val))
+			std::cout << "No machine code for neuronal networks on this system." << std::endl;
+	} else if (param_id == variance_reduction_id)
+		my_bushworld->set_variance_reduction(wp_i->second->val);
+	else if (param_id == fitness_variance_report_id)
+		fitness_variance_report = wp_i->second->val;
+	else if (param_id == pin_threads_id)
+		TaskPool::instance().set_affinity(wp_i->second->val);
+	else if (param_id == worker_report_id) {
+		worker_report = wp_i->second->val;
+		TaskPool::instance().reset_metrics();
+	}
 	else
 		std::cout << "Unknown parameter changed signal." << std::endl;
 
@@ -68,9 +117,45 @@ void Bushworldhandler::parameter_changed_signal(world_parameter_container::itera
 
 /**
  * As the name implies...
+ * With neuronal network validation switched on, the differences of the reduced
+ * precision decisions since the validation began are printed. The same is done for the
+ * hits of the decision cache. With the fitness variance report switched on, the average
+ * variance of the fitness estimates of the genomes is printed per type, which shows how
+ * many parallel worlds are needed. The worker report shows how busy every thread of the
+ * task pool was during the generation.
  */
 void Bushworldhandler::run_one_generation() {
 	World::run_generation<Bushworld>(my_bushworld);
+	
+	unsigned long validated = NeuronalNetwork::get_validated_decisions();
+	if (validated) {
+		unsigned long mismatches = NeuronalNetwork::get_decision_mismatches();
+		std::cout << "Neuronal network validation: " << mismatches << " of " << validated
+		          << " decisions (" << 100.0 * mismatches / validated
+		          << "%) differ from double precision." << std::endl;
+	}
+
+	unsigned long hits = NeuronalNetwork::get_cache_hits();
+	unsigned long misses = NeuronalNetwork::get_cache_misses();
+	if (hits + misses)
+		std::cout << "Decision cache: " << hits << " hits, " << misses << " misses ("
+		          << 100.0 * hits / (hits + misses) << "% hits)." << std::endl;
+
+	if (fitness_variance_report)
+		std::cout << "Fitness variance: fly "
+		          << my_bushworld->get_average_fitness_variance(&typeid(Fly)) << ", wasp "
+		          << my_bushworld->get_average_fitness_variance(&typeid(Wasp))
+		          << " per genome." << std::endl;
+
+	if (worker_report) {
+		TaskPool& pool = TaskPool::instance();
+		std::vector<worker_metrics> metrics = pool.get_metrics();
+		for (unsigned worker=0; worker<metrics.size(); ++worker)
+			std::cout << "Worker " << worker << ": " << 100.0 * metrics[worker].utilization()
+			          << "% busy, " << metrics[worker].tasks << " tasks ("
+			          << metrics[worker].steals << " stolen)." << std::endl;
+		pool.reset_metrics();
+	}
 }
 
 /**
@@ -83,12 +168,14 @@ void Bushworldhandler::init_world() {
 	                                           get_parameter_value(&fruit_dscr)));
 	my_bushworld->add_new_agent(&typeid(Fly), get_parameter_value(&fly_dscr)); 	
 	my_bushworld->add_new_agent(&typeid(Wasp), get_parameter_value(&wasp_dscr));
-	my_bushworld->get_population()->clear(); // First Agents should only bring genomes.
+	my_bushworld->clear_population(); // First Agents should only bring genomes.
 	my_bushworld->set_offspring_quantity(&typeid(Fly), get_parameter_value(&fly_dscr));
 	my_bushworld->set_offspring_quantity(&typeid(Wasp), get_parameter_value(&wasp_dscr));
 	my_bushworld->set_mutation_intensity(get_parameter_value(&mut_inten_dscr));
 	my_bushworld->set_mutation_rate(get_parameter_value(&mutate_dscr));
 	my_bushworld->set_max_generation_reiterations(get_parameter_value(&par_worlds_dscr));
+	my_bushworld->set_cognition_window(get_parameter_value(&cognition_window_dscr));
+	my_bushworld->set_variance_reduction(get_parameter_value(&variance_reduction_dscr));
 	
 	my_bushworld->set_insect_death_chance(2.0 / ((double)max_age));
 	my_bushworld->set_host_max_age(max_age);
@@ -106,3 +193,15 @@ const std::string Bushworldhandler::mut_inten_dscr = "Mutation Intensity";
 const std::string Bushworldhandler::par_worlds_dscr = "Parallel Worlds";
 const std::string Bushworldhandler::recombi_dscr = "Recombination";
 const std::string Bushworldhandler::hiddenlayers_dscr = "Neuronal Network Hidden Layer";
+const std::string Bushworldhandler::fly_hidden_width_dscr = "Fly Hidden Layer Width";
+const std::string Bushworldhandler::wasp_hidden_width_dscr = "Wasp Hidden Layer Width";
+const std::string Bushworldhandler::cognition_window_dscr = "Cognition Window";
+const std::string Bushworldhandler::nn_precision_dscr = "Neuronal Network Precision";
+const std::string Bushworldhandler::nn_validation_dscr = "Neuronal Network Validation";
+const std::string Bushworldhandler::decision_cache_dscr = "Decision Cache Step";
+const std::string Bushworldhandler::incremental_nn_dscr = "Incremental Neuronal Networks";
+const std::string Bushworldhandler::nn_jit_dscr = "Neuronal Network Machine Code";
+const std::string Bushworldhandler::variance_reduction_dscr = "Variance Reduction";
+const std::string Bushworldhandler::fitness_variance_report_dscr = "Fitness Variance Report";
+const std::string Bushworldhandler::pin_threads_dscr = "Pin Worker Threads";
+const std::string Bushworldhandler::worker_report_dscr = "Worker Utilization Report";
@@ -37,6 +37,20 @@ private:
 	unsigned int parallel_worlds_id;
 	unsigned int recombi_id;
 	unsigned int hiddenlayers_id;
+	unsigned int fly_hidden_width_id;
+	unsigned int wasp_hidden_width_id;
+	unsigned int cognition_window_id;
+	unsigned int nn_precision_id;
+	unsigned int nn_validation_id;
+	unsigned int decision_cache_id;
+	unsigned int incremental_nn_id;
+	unsigned int nn_jit_id;
+	unsigned int variance_reduction_id;
+	unsigned int fitness_variance_report_id;
+	bool fitness_variance_report;
+	unsigned int pin_threads_id;
+	unsigned int worker_report_id;
+	bool worker_report;
 	static const std::string wasp_dscr;
 	static const std::string fly_dscr;
 	static const std::string branch_dscr;
@@ -46,6 +60,18 @@ private:
 	static const std::string par_worlds_dscr;
 	static const std::string recombi_dscr;
 	static const std::string hiddenlayers_dscr;
+	static const std::string fly_hidden_width_dscr;
+	static const std::string wasp_hidden_width_dscr;
+	static const std::string cognition_window_dscr;
+	static const std::string nn_precision_dscr;
+	static const std::string nn_validation_dscr;
+	static const std::string decision_cache_dscr;
+	static const std::string incremental_nn_dscr;
+	static const std::string nn_jit_dscr;
+	static const std::string variance_reduction_dscr;
+	static const std::string fitness_variance_report_dscr;
+	static const std::string pin_threads_dscr;
+	static const std::string worker_report_dscr;
 };
 
 #endif // _BUSHWORLDHANDLER_H_
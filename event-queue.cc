@@ -0,0 +1,204 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ */
+
+#include "event-queue.h"
+
+/**
+ * Creates an empty queue.
+ */
+EventQueue::EventQueue() :
+	first_rank(0),
+	last_rank(0)
+{
+}
+
+/**
+ * Creates an empty queue. Only empty queues can be copied.
+ */
+EventQueue::EventQueue(const EventQueue& other) :
+	first_rank(0),
+	last_rank(0)
+{
+	BUG_CHECK(!other.empty(), "Copying an event queue with " << other.size() << " events.");
+}
+
+/**
+ * Empties this queue. Only empty queues can be assigned.
+ */
+EventQueue& EventQueue::operator=(const EventQueue& other) {
+	BUG_CHECK(!other.empty(), "Assigning an event queue with " << other.size() << " events.");
+	clear();
+	return *this;
+}
+
+/**
+ * Returns true if there is no agent in the queue.
+ */
+bool EventQueue::empty() const {
+	return heap.empty();
+}
+
+/**
+ * Returns the quantity of queued agents.
+ */
+unsigned int EventQueue::size() const {
+	return heap.size();
+}
+
+/**
+ * Removes all agents from the queue.
+ */
+void EventQueue::clear() {
+	positions.clear();
+	heap.clear();
+	first_rank = 0;
+	last_rank = 0;
+}
+
+/**
+ * Puts the event at the given heap position and remembers where its agent is.
+ */
+void EventQueue::place(const unsigned int position, const scheduled_event& event) {
+	heap[position] = event;
+	positions[event.agent.index] = position;
+}
+
+/**
+ * Moves the event at the given position towards the root until the heap order is restored.
+ */
+void EventQueue::sift_up(unsigned int position) {
+	scheduled_event moving = heap[position];
+	while (position > 0) {
+		unsigned int parent = (position - 1) / 2;
+		if (!earlier(moving, heap[parent]))
+			break;
+		place(position, heap[parent]);
+		position = parent;
+	}
+	place(position, moving);
+}
+
+/**
+ * Moves the event at the given position towards the leaves until the heap order is
+ * restored.
+ */
+void EventQueue::sift_down(unsigned int position) {
+	scheduled_event moving = heap[position];
+	const unsigned int heap_size = heap.size();
+	while (true) {
+		unsigned int child = 2 * position + 1;
+		if (child >= heap_size)
+			break;
+		if (child + 1 < heap_size && earlier(heap[child + 1], heap[child]))
+			++child;
+		if (!earlier(heap[child], moving))
+			break;
+		place(position, heap[child]);
+		position = child;
+	}
+	place(position, moving);
+}
+
+/**
+ * Queues the given agent with the given action finishing time as key. It is queued
+ * behind all agents with the same finishing time, or in front of them if in_front is
+ * true (like after EventQueue::reschedule).
+ */
+void EventQueue::push(const agent_handle agent, const turn_counter finishing_time,
+                      const bool in_front) {
+	if (agent.index >= positions.size())
+		positions.resize(agent.index + 1, NOT_QUEUED);
+	BUG_CHECK(positions[agent.index] != NOT_QUEUED, "Agent " << agent.index << 
+	          " is queued already.");
+	scheduled_event event;
+	event.finishing_time = finishing_time;
+	event.rank = in_front ? --first_rank : ++last_rank;
+	event.agent = agent;
+	heap.push_back(event);
+	sift_up(heap.size() - 1);
+}
+
+/**
+ * Returns the agent which finishes its action first. The queue must not be empty.
+ */
+agent_handle EventQueue::top() {
+	BUG_CHECK(heap.empty(), "Empty event queue.");
+	return heap.front().agent;
+}
+
+/**
+ * Returns true if the given agent is queued.
+ */
+bool EventQueue::holds(const agent_handle agent) const {
+	if (agent.index >= positions.size() || positions[agent.index] == NOT_QUEUED)
+		return false;
+	return heap[positions[agent.index]].agent == agent;
+}
+
+/**
+ * Removes the agent which finishes its action first from the queue and returns it.
+ */
+agent_handle EventQueue::pop() {
+	agent_handle popped = top();
+	remove(popped);
+	return popped;
+}
+
+/**
+ * Removes the given agent from the queue.
+ */
+void EventQueue::remove(const agent_handle agent) {
+	BUG_CHECK(!holds(agent), "Agent " << agent.index << " is not queued.");
+	unsigned int position = positions[agent.index];
+	positions[agent.index] = NOT_QUEUED;
+	heap_remove(position);
+}
+
+/**
+ * Removes the event at the given heap position.
+ */
+void EventQueue::heap_remove(const unsigned int position) {
+	scheduled_event last = heap.back();
+	heap.pop_back();
+	if (position < heap.size()) {
+		place(position, last);
+		heap_update(position);
+	}
+}
+
+/**
+ * Moves the event at the given heap position to its place after its key has changed.
+ */
+void EventQueue::heap_update(const unsigned int position) {
+	if (position > 0 && earlier(heap[position], heap[(position - 1) / 2]))
+		sift_up(position);
+	else
+		sift_down(position);
+}
+
+/**
+ * Gives the queued agent the new action finishing time and moves it to its new place.
+ * Use this after the finishing time was changed from outside, for example by
+ * World::freeze_agents. The agent keeps its rank among agents with the same finishing
+ * time.
+ */
+void EventQueue::update(const agent_handle agent, const turn_counter finishing_time) {
+	BUG_CHECK(!holds(agent), "Agent " << agent.index << " is not queued.");
+	unsigned int position = positions[agent.index];
+	heap[position].finishing_time = finishing_time;
+	heap_update(position);
+}
+
+/**
+ * Like EventQueue::update, but the agent is queued in front of all other agents with the
+ * same finishing time. This is used after an agent has started a new action.
+ */
+void EventQueue::reschedule(const agent_handle agent, const turn_counter finishing_time) {
+	BUG_CHECK(!holds(agent), "Agent " << agent.index << " is not queued.");
+	heap[positions[agent.index]].rank = --first_rank;
+	update(agent, finishing_time);
+}
@@ -0,0 +1,91 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * This file contains the class EventQueue, the scheduler of a World.
+ *
+ */
+
+#ifndef _EVENT_QUEUE_H_
+#define _EVENT_QUEUE_H_
+
+#include <vector>
+#include "debug_macros.h"
+#include "population.h"
+
+typedef double turn_counter;
+
+/** Position of agents which are not in the EventQueue. */
+#define NOT_QUEUED 0xffffffffu
+
+/**
+ * One entry of the EventQueue: the point in time when an agent finishes its current
+ * action.
+ */
+struct scheduled_event {
+	/** Copy of the agents action finishing time. Kept here to compare without pointer
+	    chasing. */
+	turn_counter finishing_time;
+	/** Events with equal finishing times are ordered by their rank (lower first). */
+	long long rank;
+	/** The agent in the population of the world. */
+	agent_handle agent;
+};
+
+/**
+ * The scheduler of a World: a queue of agent handles, ordered by their action finishing
+ * times. The queue knows the position of every queued agent, so the key of any agent can
+ * be changed quickly. Agents are found by the index of their handle, so all handles must
+ * belong to the same generation of one Population.
+ * The order is the same as a stable sort of the population by finishing time would give:
+ * new agents are queued behind all others of the same finishing time, a rescheduled agent
+ * in front of them.
+ * The queue is an indexed binary min-heap on the finishing times, all operations take
+ * O(log n) time.
+ *
+ * Copies of an EventQueue are always empty, because the handles would belong to the
+ * population of another world.
+ */
+class EventQueue {
+public:
+	EventQueue();
+	EventQueue(const EventQueue& other);
+	EventQueue& operator=(const EventQueue& other);
+
+	bool empty() const;
+	unsigned int size() const;
+	void push(const agent_handle agent, const turn_counter finishing_time,
+	          const bool in_front=false);
+	agent_handle top();
+	agent_handle pop();
+	void remove(const agent_handle agent);
+	bool holds(const agent_handle agent) const;
+	void update(const agent_handle agent, const turn_counter finishing_time);
+	void reschedule(const agent_handle agent, const turn_counter finishing_time);
+	void clear();
+
+private:
+	/** Returns true if event a has to happen before event b. */
+	inline bool earlier(const scheduled_event& a, const scheduled_event& b) const {
+		return a.finishing_time < b.finishing_time ||
+			(a.finishing_time == b.finishing_time && a.rank < b.rank);
+	}
+	void place(const unsigned int position, const scheduled_event& event);
+	void sift_up(unsigned int position);
+	void sift_down(unsigned int position);
+	void heap_remove(const unsigned int position);
+	void heap_update(const unsigned int position);
+
+	/** Heap position of every queued agent, indexed by the index of its handle.
+	    NOT_QUEUED for all others. */
+	std::vector<unsigned int> positions;
+	/** The binary heap. The earliest event is at index 0. */
+	std::vector<scheduled_event> heap;
+	/** Lowest rank given until now. */
+	long long first_rank;
+	/** Highest rank given until now. */
+	long long last_rank;
+};
+
+#endif // _EVENT_QUEUE_H_
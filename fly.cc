@@ -9,62 +9,115 @@
 #include "bushworld.h"
 
 /**
- * Sets some variables to zero.
+ * Creates a fly. Its state is stored in an InsectStore, see Fly::join_store.
  */
 Fly::Fly(genome_ptr mygen) : 
-	Insect(mygen), 
-	fruits_on_current_branch_seen_free(0),
-	free_fruits_on_other_branches_seen(0),
-	foreign_fly_eggs_on_current_branch_seen(0),
-	own_eggs_seen(0),
-	all_own_eggs_seen(0),
-	laid_eggs(0),
-	cluster_laid_eggs(0),
-	bad_fruits_seen(0)
+	Insect(mygen)
 { 
 	agent_type = "Fly";
 }
 
+/**
+ * Puts this fly into the fly columns of the given store.
+ */
+void Fly::join_store(InsectStore* store) {
+	fly_columns* flys = store->get_flys();
+	set_columns(flys, flys->add_row());
+}
+
 /**
  * The Fly uses this methode to decide what to do next. It gets a pointer to the flys
  * perception in this moment and has to return the flys wanted action. The World tries to
  * do that action -- but it must not succeed.
  */
 action Fly::cognite(const perception* pcpt) {
-	cognition_start_statistics(pcpt);
 	action ret;
 
-	if (pcpt->fruit_free) {
-		ret.intensity = 1.0;
-		ret.type = LAY_EGG;
-		++laid_eggs;
-		++cluster_laid_eggs;
-		++fruits_on_current_branch_seen_free;
-	} else {
-		if (!pcpt->own_eggs_in_fruit)
-			++bad_fruits_seen;
-		foreign_fly_eggs_on_current_branch_seen += pcpt->foreign_eggs_in_fruit;
-		own_eggs_seen += pcpt->own_eggs_in_fruit;
-		all_own_eggs_seen += pcpt->own_eggs_in_fruit;
-
-		nn_signals_ptr sigs = nn_signals_ptr(new nn_signals()); // The perception vector.
+	if (perceive(pcpt, &ret)) {
+		double sigs[FLY_NN_INPUTS]; // The perception vector.
 		fill_input_signals(sigs, pcpt);
+		decide(pcpt, neuronal_network(sigs, FLY_NN_INPUTS), &ret);
+	}
 
-		if (neuronal_network(sigs)) {
-			static const double time_scaler = 0.05;
-			double branchtime = (pcpt->current_time - last_branch_arrival_time) * time_scaler;
-			if (branchtime)
-				reward_rate_sum += cluster_laid_eggs / branchtime;
-			leave_branch(&ret);
-			last_branch_leaving_time = pcpt->current_time;
-		} else { 
-			ret.type = GO_TO_FRUIT;
-			ret.intensity = 1.0;
+	return ret;
+}
+
+/**
+ * The same as Fly::cognite, but for several flys at once. First all flys look at their
+ * perceptions, then all neuronal networks are computed together (see
+ * Agent::neuronal_networks), and at last the decisions are turned into actions. The
+ * containers in between are taken from scratch, so nothing is allocated.
+ */
+void Fly::cognite_batch(const agent_ptr* agents, const perception* pcpts, action* actions,
+                        const unsigned int quantity, cognition_batch& scratch) {
+	scratch.thinker_positions.clear();
+	scratch.thinkers.clear();
+	for (unsigned i=0; i<quantity; ++i) {
+		Fly* cooper = static_cast<Fly*>(agents[i].get());
+		if (cooper->perceive(&pcpts[i], &actions[i])) {
+			scratch.thinker_positions.push_back(i);
+			scratch.thinkers.push_back(cooper);
 		}
-		
 	}
 
-	return ret;
+	const unsigned int thinkers = scratch.thinkers.size();
+	scratch.signals.resize(thinkers * FLY_NN_INPUTS);
+	for (unsigned t=0; t<thinkers; ++t)
+		static_cast<Fly*>(scratch.thinkers[t])->fill_input_signals(
+			&scratch.signals[t * FLY_NN_INPUTS], &pcpts[scratch.thinker_positions[t]]);
+	bool* leaving = scratch.get_decisions(thinkers);
+	neuronal_networks(scratch.thinkers.data(), scratch.signals.data(), FLY_NN_INPUTS, thinkers,
+	                  leaving, scratch);
+
+	for (unsigned t=0; t<thinkers; ++t) {
+		unsigned int i = scratch.thinker_positions[t];
+		static_cast<Fly*>(scratch.thinkers[t])->decide(&pcpts[i], leaving[t], &actions[i]);
+	}
+}
+
+/**
+ * First step of a cognition: the fly looks at its perception and updates its
+ * statistics. On a free fruit the fly lays an egg, which is written to ret. Otherwise
+ * this returns true, because the fly has to think about leaving the branch.
+ */
+bool Fly::perceive(const perception* pcpt, action* ret) {
+	cognition_start_statistics(pcpt);
+	fly_columns& c = cols();
+
+	if (pcpt->fruit_free) {
+		ret->intensity = 1.0;
+		ret->type = LAY_EGG;
+		++c.laid_eggs[row];
+		++c.cluster_laid_eggs[row];
+		++c.fruits_on_current_branch_seen_free[row];
+		return false;
+	}
+
+	if (!pcpt->own_eggs_in_fruit)
+		++c.bad_fruits_seen[row];
+	c.foreign_fly_eggs_on_current_branch_seen[row] += pcpt->foreign_eggs_in_fruit;
+	c.own_eggs_seen[row] += pcpt->own_eggs_in_fruit;
+	c.all_own_eggs_seen[row] += pcpt->own_eggs_in_fruit;
+	return true;
+}
+
+/**
+ * Last step of a cognition: turns the decision of the neuronal network (leave the branch
+ * or not) into an action.
+ */
+void Fly::decide(const perception* pcpt, const bool leave, action* ret) {
+	if (leave) {
+		fly_columns& c = cols();
+		static const double time_scaler = 0.05;
+		double branchtime = (pcpt->current_time - c.last_branch_arrival_time[row]) * time_scaler;
+		if (branchtime)
+			c.reward_rate_sum[row] += c.cluster_laid_eggs[row] / branchtime;
+		leave_branch(ret);
+		c.last_branch_leaving_time[row] = pcpt->current_time;
+	} else { 
+		ret->type = GO_TO_FRUIT;
+		ret->intensity = 1.0;
+	}
 }
 
 /**
@@ -72,13 +125,14 @@ action Fly::cognite(const perception* pcpt) {
  * Mainly some statistics are done here.
  */
 void Fly::leave_branch(action* ret) {
-	free_fruits_on_other_branches_seen += fruits_on_current_branch_seen_free;
-	foreign_fly_eggs_on_current_branch_seen = 0;
-	fruits_on_current_branch_seen_free = 0;
-	own_eggs_seen = 0;
-	cluster_laid_eggs = 0;
-	branch_hopping = true;
-	++cluster_jumps;
+	fly_columns& c = cols();
+	c.free_fruits_on_other_branches_seen[row] += c.fruits_on_current_branch_seen_free[row];
+	c.foreign_fly_eggs_on_current_branch_seen[row] = 0;
+	c.fruits_on_current_branch_seen_free[row] = 0;
+	c.own_eggs_seen[row] = 0;
+	c.cluster_laid_eggs[row] = 0;
+	c.branch_hopping[row] = true;
+	++c.cluster_jumps[row];
 	if (get_genome_ptr()->get_gene(next_gene++) < World::randone())
 		ret->type = GO_TO_BRANCH_WEST;
 	else
@@ -88,30 +142,31 @@ void Fly::leave_branch(action* ret) {
 
 /**
  * Collects some data for the neuronal network, which may hopefully be helpful there.
+ * The FLY_NN_INPUTS signals are written to sigs. If you add one, increase FLY_NN_INPUTS.
  */
-void Fly::fill_input_signals(nn_signals_ptr sigs, const perception* pcpt) {
+void Fly::fill_input_signals(double* sigs, const perception* pcpt) {
+	const fly_columns& c = cols();
 	// Collected personal statistics as perceptions:
-	sigs->push_back(sigmoid(foreign_fly_eggs_on_current_branch_seen));  // on current branch
-	// sigs->push_back(sigmoid(fruits_on_current_branch_seen_free));		// on current branch
-	sigs->push_back(sigmoid(laid_eggs));								// in the whole bush
-	sigs->push_back(sigmoid(cluster_laid_eggs));						// on current branch
-	sigs->push_back(sigmoid(cluster_jumps));							// in the whole bush
-	sigs->push_back(sigmoid((pcpt->current_time - birth_time) / (max_age - birth_time))); // Lifetime normalized
-	//sigs->push_back(sigmoid(free_fruits_on_other_branches_seen));		
+	sigs[0] = sigmoid(c.foreign_fly_eggs_on_current_branch_seen[row]);  // on current branch
+	sigs[1] = sigmoid(c.laid_eggs[row]);							// in the whole bush
+	sigs[2] = sigmoid(c.cluster_laid_eggs[row]);					// on current branch
+	sigs[3] = sigmoid(c.cluster_jumps[row]);						// in the whole bush
+	sigs[4] = sigmoid((pcpt->current_time - birth_time) / (max_age - birth_time)); // Lifetime normalized
 
 	// McNamara-Houston-input (reward rates):
-	double average_reward_rate = cluster_jumps ? reward_rate_sum / cluster_jumps : 0.0;
-	sigs->push_back(sigmoid(average_reward_rate)); // Average reward rate.
+	double average_reward_rate = c.cluster_jumps[row] ? 
+		c.reward_rate_sum[row] / c.cluster_jumps[row] : 0.0;
+	sigs[5] = sigmoid(average_reward_rate); // Average reward rate.
 	static const double time_scaler = 0.05;
-	double branchtime = (pcpt->current_time - last_branch_arrival_time) * time_scaler;
-	double current_branch_reward_rate = branchtime ? cluster_laid_eggs / branchtime : 0.0;
-	sigs->push_back(sigmoid(current_branch_reward_rate)); // Reward rate.
-
-	// A static input for the neuronal network.
-	// sigs->push_back(0.5);
+	double branchtime = (pcpt->current_time - c.last_branch_arrival_time[row]) * time_scaler;
+	double current_branch_reward_rate = branchtime ? c.cluster_laid_eggs[row] / branchtime : 0.0;
+	sigs[6] = sigmoid(current_branch_reward_rate); // Reward rate.
 
-	// A random input for the neuronal network.
-	// sigs->push_back(World::randone());
+	// Unused inputs. To use one, set FLY_NN_INPUTS to 8.
+	// sigs[7] = sigmoid(c.fruits_on_current_branch_seen_free[row]);	// on current branch
+	// sigs[7] = sigmoid(c.free_fruits_on_other_branches_seen[row]);
+	// sigs[7] = 0.5;					// A static input.
+	// sigs[7] = World::randone();		// A random input.
 }
 
 /**
@@ -216,9 +216,11 @@ void GenomeDrawArea::draw_grid(const Cairo::RefPtr<Cairo::Context>& cr, unsigned
 
 /**
  * This is called when the system wants the draw area redrawed.
- * Here the whole drawing is done.
+ * Here the whole drawing is done. The data set is locked meanwhile, because the
+ * statistics pipeline may add a generation to it.
  */
 bool GenomeDrawArea::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
+	std::lock_guard<std::mutex> lock(my_data_set->mutex);
 	if (!my_data_set->genomes.size())
 		return true;
 	double upper_val = my_adjustment->get_upper();
@@ -24,6 +24,8 @@ Genome::Genome(const std::type_info& agents_t_id,
 	my_agents_type("Unknown Agent"),
 	my_agents_type_id(&agents_t_id),
 	fitness(0.0),
+	fitness_variance(0.0),
+	slot(0),
 	offspring_quantity(0),
 	last_offspring_quantity(0),
 	mutation_max_intensity(max_mut_intensity)
@@ -97,6 +99,7 @@ void Genome::add_gene(const unsigned int gene_no, const double gene_value) {
 		for (unsigned i=old_genes_size; i<(gene_no+1); ++i)
 			genes.at(i) = World::randone();
 	}
+	network.reset();
 	genes.at(gene_no) += gene_value;
 }
 
@@ -114,6 +117,7 @@ void Genome::set_gene(const unsigned int gene_no, const double gene_value) {
 		for (unsigned i=old_genes_size; i<(gene_no); ++i)
 			genes.at(i) = World::randone();
 	}
+	network.reset();
 	genes.at(gene_no) = gene_value;
 }
 
@@ -130,6 +134,7 @@ void Genome::divide_gene(const unsigned int gene_no, const double divider) {
 		for (unsigned i=old_genes_size; i<(gene_no); ++i)
 			genes.at(i) = World::randone();
 	}
+	network.reset();
 	genes.at(gene_no) /= divider;
 }
 
@@ -156,6 +161,7 @@ void Genome::createEmptyGenes(int gene_quantity, double init_val) {
 	if (gene_quantity < 0)
 		gene_quantity = genes.size();
 	genes = gene_container(gene_quantity);
+	network.reset();
 	if (init_val == -1.0)
 		for (auto& gene: genes)
 			gene = World::randone();
@@ -193,6 +199,21 @@ void Genome::set_fitness(const double new_fitness) {
 	fitness = new_fitness;
 }
 
+/**
+ * Returns the variance of the fitness of the last generation, i.e. the square of its
+ * standard error. Zero if it could not be estimated.
+ */
+double Genome::get_fitness_variance() const {
+	return fitness_variance;
+}
+
+/**
+ * Sets the variance of the fitness, see Genome::get_fitness_variance.
+ */
+void Genome::set_fitness_variance(const double new_variance) {
+	fitness_variance = new_variance;
+}
+
 /**
  * Merges another genome into this one.
  * If this genome is bigger (more genes) or of the same size, nothing happens.
@@ -212,6 +233,26 @@ void Genome::merge(genome_ptr other_genome) {
 	}
 }
 
+/**
+ * Returns the neuronal network built from the genes beginning with first_gene, for the
+ * given quantity of input signals, hidden layers and outputs per hidden layer (see
+ * Agent::neuronal_network).
+ * It is compiled at the first call and then kept until the genes change, a network
+ * with another topology is asked for or the precision of the networks changes. Then also room for GENOME_SPARE_GENES genes
+ * behind the network is made, so creating them later does not allocate memory.
+ */
+const NeuronalNetwork& Genome::get_neuronal_network(const unsigned int first_gene,
+                                                    const unsigned int input_size,
+                                                    const unsigned int hidden_layers,
+                                                    const unsigned int hidden_width) {
+	if (!network || !network->fits(first_gene, input_size, hidden_layers, hidden_width)) {
+		network = neuronal_network_ptr(new NeuronalNetwork(*this, first_gene, input_size,
+		                                                   hidden_layers, hidden_width));
+		genes.reserve(first_gene + network->get_gene_quantity() + GENOME_SPARE_GENES);
+	}
+	return *network;
+}
+
 /**
  * Increases the fitness for this genome with <inc_fitness>.
  */
@@ -313,10 +354,8 @@ void Genome::mutate() {
 	do {
 		if (!gene_quant)
 			return;
-		unsigned int mut_gene_no = World::randone() * (double)genes.size();
+		unsigned int mut_gene_no = World::randbelow(genes.size());
 		BUG_CHECK(mut_gene_no>=genes.size(), "Outer space gene should mutate.");
-		if (mut_gene_no >= genes.size()) // HACK
-			mut_gene_no = genes.size() - 1;
 		if (World::randone() < STRONG_MUTATION_CHANCE)
 			set_gene(mut_gene_no, World::randone() * max_gene_val);
 		else 
@@ -414,7 +453,7 @@ bool Genome::agents_type_equals(const std::type_info& other_type) {
 }
 
 /** Stores the amount of all genomes ever existed. */
-unsigned long Genome::genome_counter = 0;
+std::atomic<unsigned long> Genome::genome_counter(0);
 
 double Genome::mutation_rate = 0.01; 
 double Genome::min_gene_val = 0.0;
@@ -485,6 +524,7 @@ Genome Genome::operator*=(double multiplier) {
  */
 Genome Genome::operator*(double multiplier) {
 	Genome m_g = Genome(*this);
+	m_g.network.reset();
 	for (unsigned i=0; i<genes.size(); ++i)
 		m_g.genes.at(i) *= multiplier;
 	return m_g;
@@ -7,13 +7,19 @@
 #ifndef _GENOME_H_
 #define _GENOME_H_
 
+#include <atomic>
 #include <vector>
 #include <iostream>
 #include <giomm.h>
 #include "debug_macros.h"
+#include "neuronal-network.h"
 
 class Agent;
 
+/** Quantity of genes agents may read behind their neuronal network during a cognition
+    (like Fly::leave_branch), see Genome::get_neuronal_network. */
+#define GENOME_SPARE_GENES 8
+
 typedef std::vector<double> gene_container;
 typedef std::shared_ptr<std::string> string_ptr;
 typedef std::shared_ptr<std::type_info> type_info_ptr;
@@ -39,6 +45,13 @@ public:
 	double get_fitness() const;
 	void set_fitness(const double new_fitness);
 	void increase_fitness(const double inc_fitness);
+	double get_fitness_variance() const;
+	void set_fitness_variance(const double new_variance);
+	/** Returns the slot of this genome in the current generation, see
+	    World::run_generation. */
+	inline unsigned int get_slot() const { return slot; }
+	/** Sets the slot of this genome. */
+	inline void set_slot(const unsigned int new_slot) { slot = new_slot; }
 	unsigned long get_genome_id() const;
 	void set_new_id();
 	void set_offspring_quantity(const int new_oq);
@@ -71,6 +84,10 @@ public:
 	string_ptr get_gene_description(const unsigned int gene_no);
 	void set_gene_description(const unsigned int gene_no, string_ptr new_dscr);
 	void merge(genome_ptr other_genome);
+	const NeuronalNetwork& get_neuronal_network(const unsigned int first_gene,
+	                                            const unsigned int input_size,
+	                                            const unsigned int hidden_layers,
+	                                            const unsigned int hidden_width);
 	static genome_ptr recombine(genome_ptr parent_1, genome_ptr parent_2);
 
 	Genome operator+=(Genome other_g);
@@ -94,8 +111,16 @@ private:
 	gene_container genes;
 	/** Fitness of this genome (genotype). */
 	double fitness;
-	/** Stores the number of all genomes ever existed. */	
-	static unsigned long genome_counter;
+	/** Variance of the fitness of the last generation as an estimate of the true
+	    fitness, see World::reduce_fitness. */
+	double fitness_variance;
+	/** Dense index of this genome in the genepool of the current generation. Copies
+	    of the genome in the parallel worlds keep it, so their results can be stored
+	    in arrays without looking the genome up. */
+	unsigned int slot;
+	/** Stores the number of all genomes ever existed. Genomes are made in several
+	    threads (e.g. by the StatisticsPipeline). */	
+	static std::atomic<unsigned long> genome_counter;
 	/** Unique id of this genome. */
 	unsigned long genome_id;
 	/** Quantity of offspring agents from this genome in every generation. */
@@ -112,6 +137,9 @@ private:
 	static double max_gene_val;
 	/** Container of human readable gene descriptions. */
 	std::vector<string_ptr> gene_descriptions;
+	/** The neuronal network compiled from the genes, or nothing. It is forgotten when
+	    genes change. Copies of the genome share it. */
+	neuronal_network_ptr network;
 			
 };
 
@@ -0,0 +1,111 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ */
+
+#include "insect-store.h"
+
+/**
+ * Adds a row for a new insect, which has not arrived at any branch yet. Returns the row
+ * number.
+ */
+unsigned int insect_columns::add_row() {
+	unsigned int row = size();
+	branch.push_back(0);
+	fruit.push_back(0);
+	last_branch_arrival_time.push_back(0.0);
+	last_branch_leaving_time.push_back(-1.0);
+	branch_hopping.push_back(true);
+	travel_time_sum.push_back(0.0);
+	cluster_jumps.push_back(0.0);
+	reward_rate_sum.push_back(0.0);
+	laid_eggs.push_back(0);
+	cluster_laid_eggs.push_back(0);
+	own_eggs_seen.push_back(0);
+	bad_fruits_seen.push_back(0);
+	return row;
+}
+
+/**
+ * Removes all rows.
+ */
+void insect_columns::clear() {
+	branch.clear();
+	fruit.clear();
+	last_branch_arrival_time.clear();
+	last_branch_leaving_time.clear();
+	branch_hopping.clear();
+	travel_time_sum.clear();
+	cluster_jumps.clear();
+	reward_rate_sum.clear();
+	laid_eggs.clear();
+	cluster_laid_eggs.clear();
+	own_eggs_seen.clear();
+	bad_fruits_seen.clear();
+}
+
+/**
+ * Adds a row for a new fly. Returns the row number.
+ */
+unsigned int fly_columns::add_row() {
+	fruits_on_current_branch_seen_free.push_back(0);
+	free_fruits_on_other_branches_seen.push_back(0);
+	foreign_fly_eggs_on_current_branch_seen.push_back(0);
+	all_own_eggs_seen.push_back(0);
+	return insect_columns::add_row();
+}
+
+/**
+ * Removes all rows.
+ */
+void fly_columns::clear() {
+	insect_columns::clear();
+	fruits_on_current_branch_seen_free.clear();
+	free_fruits_on_other_branches_seen.clear();
+	foreign_fly_eggs_on_current_branch_seen.clear();
+	all_own_eggs_seen.clear();
+}
+
+/**
+ * Adds a row for a new wasp. Returns the row number.
+ */
+unsigned int wasp_columns::add_row() {
+	fly_eggs_seen.push_back(0);
+	empty_fruits_seen.push_back(0);
+	foreign_wasp_eggs_seen.push_back(0);
+	return insect_columns::add_row();
+}
+
+/**
+ * Removes all rows.
+ */
+void wasp_columns::clear() {
+	insect_columns::clear();
+	fly_eggs_seen.clear();
+	empty_fruits_seen.clear();
+	foreign_wasp_eggs_seen.clear();
+}
+
+/**
+ * Returns the columns of the flys.
+ */
+fly_columns* InsectStore::get_flys() {
+	return &flys;
+}
+
+/**
+ * Returns the columns of the wasps.
+ */
+wasp_columns* InsectStore::get_wasps() {
+	return &wasps;
+}
+
+/**
+ * Forgets all insects.
+ */
+void InsectStore::clear() {
+	flys.clear();
+	wasps.clear();
+}
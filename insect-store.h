@@ -0,0 +1,108 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * This file contains the class InsectStore, which keeps the often used data of all
+ * insects of a Bushworld in columns.
+ *
+ */
+
+#ifndef _INSECT_STORE_H_
+#define _INSECT_STORE_H_
+
+#include <vector>
+
+typedef double turn_counter;
+
+/**
+ * The state of insects which is needed in every cognition and action, one column
+ * (vector) per variable. The insect with row number r has its values at index r of
+ * every column. This keeps the data of neighbouring insects together in memory.
+ */
+struct insect_columns {
+	/** The branch (cluster) where the insect resides momentarily. */
+	std::vector<unsigned int> branch;
+	/** The fruit on the branch where the insect resides momentarily. */
+	std::vector<unsigned int> fruit;
+	/** Last point in time when the insect arrived at a branch. */
+	std::vector<turn_counter> last_branch_arrival_time;
+	/** Last point in time when the insect left a branch. */
+	std::vector<turn_counter> last_branch_leaving_time;
+	/** Not zero if the insect changes the branch. */
+	std::vector<unsigned char> branch_hopping;
+	/** Sum of all time periods the insect has not been on a branch. */
+	std::vector<turn_counter> travel_time_sum;
+	/** Number of left clusters. */
+	std::vector<double> cluster_jumps;
+	/** Sum of all cluster-reward-rates until now. */
+	std::vector<double> reward_rate_sum;
+	/** All eggs the insect laid. */
+	std::vector<unsigned int> laid_eggs;
+	/** Laid eggs in the current cluster. */
+	std::vector<unsigned int> cluster_laid_eggs;
+	/** Own eggs found on the current branch. */
+	std::vector<unsigned int> own_eggs_seen;
+	/** All found fruits where no laying was possible. */
+	std::vector<unsigned int> bad_fruits_seen;
+
+	unsigned int add_row();
+	void clear();
+	/** Returns the quantity of rows. */
+	inline unsigned int size() const { return branch.size(); }
+};
+
+/**
+ * Columns for flys: the common insect columns and the ones only a fly needs.
+ */
+struct fly_columns : public insect_columns {
+	/** Unused (egg-free) fruits seen on the current branch. This value means also 'laid
+	    eggs in this branch'. */
+	std::vector<unsigned int> fruits_on_current_branch_seen_free;
+	/** Free fruits on other branches, actually unused variable. */
+	std::vector<unsigned int> free_fruits_on_other_branches_seen;
+	/** Egg from other flys seen on the current branch. */
+	std::vector<unsigned int> foreign_fly_eggs_on_current_branch_seen;
+	/** Own eggs found until now in the whole world. */
+	std::vector<unsigned int> all_own_eggs_seen;
+
+	unsigned int add_row();
+	void clear();
+};
+
+/**
+ * Columns for wasps: the common insect columns and the ones only a wasp needs.
+ */
+struct wasp_columns : public insect_columns {
+	/** Quantity of found fly eggs in the current branch. */
+	std::vector<unsigned int> fly_eggs_seen;
+	/** Quantity of found empty fruits in the current branch. */
+	std::vector<unsigned int> empty_fruits_seen;
+	/** Quantity of found eggs of a different wasp genome in the current branch. */
+	std::vector<unsigned int> foreign_wasp_eggs_seen;
+
+	unsigned int add_row();
+	void clear();
+};
+
+/**
+ * The often used state of all insects of one Bushworld, split into flys and wasps.
+ * Every Insect which lives in the world has one row here (see Insect::join_store).
+ * Rows are not reused before InsectStore::clear, so the data of dead insects stays
+ * readable for statistics until then. Things which are only needed for statistics stay
+ * in the Insect objects.
+ */
+class InsectStore {
+public:
+	fly_columns* get_flys();
+	wasp_columns* get_wasps();
+	void clear();
+
+private:
+	/** The columns of all flys. */
+	fly_columns flys;
+	/** The columns of all wasps. */
+	wasp_columns wasps;
+};
+
+#endif // _INSECT_STORE_H_
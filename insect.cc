@@ -9,36 +9,56 @@
 #include "insect.h"
 
 double Insect::get_cluster_jumps() const {
-	return cluster_jumps;
+	return columns ? columns->cluster_jumps[row] : cluster_jumps;
 }
 
 void Insect::set_cluster_jumps(double new_jumps) {
-	cluster_jumps = new_jumps;
+	if (columns)
+		columns->cluster_jumps[row] = new_jumps;
+	else
+		cluster_jumps = new_jumps;
+}
+
+/**
+ * Tells the insect where its state is stored. This is done by Insect::join_store of the
+ * derived classes.
+ */
+void Insect::set_columns(insect_columns* new_columns, const unsigned int new_row) {
+	BUG_CHECK(!new_columns || new_row >= new_columns->size(), "Insect row " << new_row << 
+	          " does not exist.");
+	columns = new_columns;
+	row = new_row;
 }
 
 void Insect::set_position(const int branch_pos, const int fruit_pos) {
-	insect_position.branch = branch_pos;
-	insect_position.fruit = fruit_pos;
+	BUG_CHECK(!columns, "Insect is in no InsectStore.");
+	columns->branch[row] = branch_pos;
+	columns->fruit[row] = fruit_pos;
 }
 
 void Insect::set_fruit_pos(const int fruit_pos) {
-	insect_position.fruit = fruit_pos;
+	BUG_CHECK(!columns, "Insect is in no InsectStore.");
+	columns->fruit[row] = fruit_pos;
 }
 
 /**
  * Returns the insects position (branch and fruit number) in the bush.
  */
 bush_position Insect::get_position() const {
-	return insect_position;
+	BUG_CHECK(!columns, "Insect is in no InsectStore.");
+	bush_position ret;
+	ret.branch = columns->branch[row];
+	ret.fruit = columns->fruit[row];
+	return ret;
 }
 
 /**
- * Should return true if the insect is a parasitoid (Wasp) and false if it is a host
- * (Fly). Overwrite this method in a derived class. If you don't do it, it tells that 
+ * Returns true if the insect is a parasitoid (Wasp) and false if it is a host (Fly).
+ * This is given to the constructor by the derived class. If it does not, it tells that 
  * your new class is a host.
  */
-bool Insect::is_parasitoid() {
-	return false;
+bool Insect::is_parasitoid() const {
+	return parasitoid;
 }
 
 /**
@@ -46,7 +66,8 @@ bool Insect::is_parasitoid() {
  */
 void Insect::set_branch_pos(const int new_branch_pos) {
 	BUG_CHECK(new_branch_pos<0, "Negative branch position.");
-	insect_position.branch = new_branch_pos;
+	BUG_CHECK(!columns, "Insect is in no InsectStore.");
+	columns->branch[row] = new_branch_pos;
 }
 
 /**
@@ -54,11 +75,13 @@ void Insect::set_branch_pos(const int new_branch_pos) {
  * Returns -1.0 if the insect never did.
  */
 turn_counter Insect::get_last_branch_arrival_time() const {
-	return last_branch_arrival_time;
+	BUG_CHECK(!columns, "Insect is in no InsectStore.");
+	return columns->last_branch_arrival_time[row];
 }
 
 bool Insect::is_between_branches() {
-	return branch_hopping;
+	BUG_CHECK(!columns, "Insect is in no InsectStore.");
+	return columns->branch_hopping[row];
 }
 
 /**
@@ -70,12 +93,12 @@ turn_counter Insect::get_avg_branch_time() {
 	if (avg_branch_time == -1.0) {
 		double span = get_life_span();
 		if (!span) {
-			BUG_CHECK(travel_time_sum, "No life span but travelled?");
+			BUG_CHECK(get_travel_time_sum(), "No life span but travelled?");
 			avg_branch_time = 0.0;
 			return avg_branch_time;
 		}
-		double branch_time = span - travel_time_sum;
-		avg_branch_time = branch_time / (cluster_jumps + 1.0);
+		double branch_time = span - get_travel_time_sum();
+		avg_branch_time = branch_time / (get_cluster_jumps() + 1.0);
 	}
 	return avg_branch_time;
 }
@@ -93,7 +116,7 @@ void Insect::set_avg_branch_time(turn_counter new_avg_b_t) {
  * Returns the sum of all time periods this insect has not been on a fruit.
  */
 turn_counter Insect::get_travel_time_sum() {
-	return travel_time_sum;
+	return columns ? columns->travel_time_sum[row] : travel_time_sum;
 }
 
 /**
@@ -101,8 +124,10 @@ turn_counter Insect::get_travel_time_sum() {
  * Travel time lengths can differ because of the flying distance.
  */
 turn_counter Insect::get_average_travel_time() {
-	BUG_CHECK(cluster_jumps && !travel_time_sum, "Cluster jumps without travel time.");
-	return cluster_jumps ? travel_time_sum / (double)cluster_jumps : 0.0;
+	double jumps = get_cluster_jumps();
+	turn_counter travel_time = get_travel_time_sum();
+	BUG_CHECK(jumps && !travel_time, "Cluster jumps without travel time.");
+	return jumps ? travel_time / jumps : 0.0;
 }
 
 /** 
@@ -117,10 +142,11 @@ void Insect::cognition_start_statistics(const perception* pcpt) {
 		birth_time = pcpt->current_time;
 	
 	// If the insect arrived just now on this branch.
-	if (branch_hopping) {
-		if (cluster_jumps)
-			travel_time_sum += pcpt->current_time - last_branch_leaving_time;
-		last_branch_arrival_time = pcpt->current_time;
-		branch_hopping = false;
+	insect_columns& c = *columns;
+	if (c.branch_hopping[row]) {
+		if (c.cluster_jumps[row])
+			c.travel_time_sum[row] += pcpt->current_time - c.last_branch_leaving_time[row];
+		c.last_branch_arrival_time[row] = pcpt->current_time;
+		c.branch_hopping[row] = false;
 	}
 }
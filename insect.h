@@ -10,6 +10,7 @@
 
 #include "agent.h"
 #include "bushworld.h"
+#include "insect-store.h"
 #include "debug_macros.h"
 
 class Insect;
@@ -22,12 +23,13 @@ typedef std::shared_ptr<Insect> insect_ptr;
  */
 class Insect : public Agent {
 public:
-	Insect(const genome_ptr mygen) : Agent(mygen),
-					 last_branch_arrival_time(0.0), last_branch_leaving_time(-1.0), 
-					 branch_hopping(true), avg_branch_time(-1.0), travel_time_sum(0.0), 
-					 cluster_jumps(0.0), reward_rate_sum(0.0)
+	Insect(const genome_ptr mygen, const bool is_parasitoid=false) : Agent(mygen),
+					 columns(NULL), row(0), parasitoid(is_parasitoid), avg_branch_time(-1.0), 
+					 travel_time_sum(0.0), cluster_jumps(0.0)
 	{agent_type = "Insect";}
 
+	/** Puts this insect into the given store. It gets a new row there. */
+	virtual void join_store(InsectStore* store) = 0;
 	void set_position(const int branch_pos, const int fruit_pos);
 	void set_fruit_pos(const int fruit_pos);
 	void set_branch_pos(const int new_branch_pos);
@@ -37,34 +39,36 @@ public:
 	double get_cluster_jumps() const;
 	void set_cluster_jumps(double new_jumps);
 	virtual action cognite(const perception* agents_personal_perception) = 0;
-	virtual bool is_parasitoid();
+	bool is_parasitoid() const;
 	bool is_between_branches();
 	turn_counter get_avg_branch_time();
 	void set_avg_branch_time(turn_counter new_avg_b_t);
 	turn_counter get_travel_time_sum();
 	turn_counter get_average_travel_time();
+	/** Returns the columns of the InsectStore this insect lives in. */
+	inline insect_columns* get_columns() const { return columns; }
+	/** Returns the row of this insect in its columns. */
+	inline unsigned int get_row() const { return row; }
 
 protected: 
 	void cognition_start_statistics(const perception* perc);
 	//void after_death_statistics();
-		
-	/** Last point in time when the insect arrived at a branch. */
-	turn_counter last_branch_arrival_time;
-	turn_counter last_branch_leaving_time;
-	/** This is true if the insect changes the branch. */
-	bool branch_hopping;
+	void set_columns(insect_columns* new_columns, const unsigned int new_row);
 
+	/** The columns with the state of this insect, NULL if the insect is in no
+	    InsectStore. */
+	insect_columns* columns;
+	/** The row of this insect in the columns. */
+	unsigned int row;
+		
+private:
+	/** True for parasitoids (Wasp), false for hosts (Fly). */
+	bool parasitoid;
 	turn_counter avg_branch_time;
-
+	/** Travel time sum of an insect which is in no InsectStore. */
 	turn_counter travel_time_sum;
-	/** Number of left clusters. */
+	/** Number of left clusters of an insect which is in no InsectStore. */
 	double cluster_jumps;
-	/** Sum of all cluster-reward-rates until now. */
-	double reward_rate_sum;
-		
-private:
-	/** Current insects position in the world. */
-	bush_position insect_position;
 };
 
 #endif // _INSECT_H_
@@ -13,6 +13,7 @@
 #include "mainwindow.h"
 #include "worldhandler.h"
 #include "simulation-database.h"
+#include "statistics-pipeline.h"
 #include "genome-window.h"
 
 
@@ -41,6 +42,8 @@ Mainwindow::Mainwindow(worldhandler_ptr new_world_handler) :
 	set_title("LEvoSim v1.1");
 	set_size_request(280, 600); 
 	sim_db = world_handler->create_database();
+	statistics = statistics_pipeline_ptr(new StatisticsPipeline(sim_db,
+	                                                           [this] { repaint_signal(); }));
 	stat_windows = button_container(sim_db->data_sets()->size());
 	set_resizable(false);
 	add(main_table);
@@ -155,6 +158,7 @@ Mainwindow::~Mainwindow() {
 	program_must_end = true;
 	start_sim_condition.signal(); 
 	simulation_thread->join();
+	statistics.reset(); // Collects the last snapshots.
 }
 
 /**
@@ -175,6 +179,8 @@ void Mainwindow::paint_stats() {
 
 /**
  * This method is run in a sperate thread. It calculates the simulation.
+ * The statistics of every generation are collected by the statistics pipeline, while the
+ * next generation is calculated.
  */
 void Mainwindow::run_world_loop() {
 	while (!program_must_end) {
@@ -190,9 +196,8 @@ void Mainwindow::run_world_loop() {
 		}
 		world_handler->apply_changes();
 		world_handler->run_one_generation();
-		sim_db->collect(world_handler->get_world());
+		statistics->push(world_handler->get_world()->make_snapshot());
 		simulation_is_idle = true;
-		repaint_signal();
 	}
 }
 
@@ -253,13 +258,15 @@ void Mainwindow::on_save_clicked() {
 }
 
 /**
- * Tells the simulation to stop and waits until this is done.
+ * Tells the simulation to stop and waits until this is done and all statistics are
+ * collected.
  */
 void Mainwindow::wait_until_idle() {
 	on_stop_clicked();
 	// Spinlock until simulation stops.
 	while (!simulation_is_idle)
 		usleep(30);
+	statistics->flush();
 }
 
 /**
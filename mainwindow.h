@@ -17,6 +17,7 @@
 #include <gtkmm.h>
 #include <vector>
 #include "simulation-database.h"
+#include "statistics-pipeline.h"
 #include "worldhandler.h"
 #include "genome-window.h"
 #include "debug_macros.h"
@@ -111,6 +112,7 @@ private:
 	Glib::Cond start_sim_condition;
 	Glib::Mutex start_sim_mutex;
 	simulation_database_ptr sim_db;
+	statistics_pipeline_ptr statistics;
 	Gtk::Table main_table, stat_table, scaler_table, windows_button_table;
 	button_container stat_windows;
 	Gtk::ScrolledWindow scaler_scrollbox, button_scrollbox;
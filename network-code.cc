@@ -0,0 +1,226 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include "network-code.h"
+#include "neuronal-network.h"
+
+#ifdef NN_JIT
+#include <sys/mman.h>
+
+/** Bytes on the stack for the signals of two layers. */
+#define STACK_SIZE (2 * NN_MAX_SIGNALS * 8)
+
+/**
+ * Machine code in the making, with a pool of double constants behind the code which
+ * instructions address relative to the instruction pointer.
+ */
+struct code_buffer {
+	/** The code. */
+	std::vector<unsigned char> bytes;
+	/** The constants. */
+	std::vector<double> constants;
+	/** Positions of the 32 bit distances to constants in the code, and the numbers of
+	    the constants. */
+	std::vector<std::pair<size_t, size_t>> constant_uses;
+
+	/** Appends the given bytes. */
+	void emit(std::initializer_list<unsigned char> code) {
+		bytes.insert(bytes.end(), code);
+	}
+	/** Appends a 32 bit number. */
+	void emit32(const uint32_t value) {
+		for (unsigned b=0; b<4; ++b)
+			bytes.push_back(value >> (8 * b));
+	}
+	/** Appends the distance to a new constant. Must be the end of an instruction. */
+	void emit_constant(const double value) {
+		constant_uses.push_back(std::make_pair(bytes.size(), constants.size()));
+		constants.push_back(value);
+		emit32(0);
+	}
+	/** Appends the constants and fills in their distances. */
+	void link() {
+		while (bytes.size() % 8)
+			bytes.push_back(0xcc);
+		size_t pool = bytes.size();
+		for (auto const& use: constant_uses) {
+			uint32_t distance = pool + 8 * use.second - (use.first + 4);
+			std::memcpy(&bytes[use.first], &distance, 4);
+		}
+		bytes.resize(pool + 8 * constants.size());
+		std::memcpy(&bytes[pool], constants.data(), 8 * constants.size());
+	}
+};
+
+/**
+ * Writes the code for a network in the layout of NeuronalNetwork. The input signals are
+ * expected at rdi, the layer signals are kept on the stack, the decision is returned in
+ * al. Only xmm0 to xmm4 are used.
+ */
+static void generate(code_buffer& code, const std::vector<double>& weightings,
+                     const std::vector<double>& thresholds, const unsigned int input_size,
+                     const unsigned int hidden_layers, const unsigned int hidden_width) {
+	code.emit({0x48, 0x81, 0xec}); code.emit32(STACK_SIZE);   // sub rsp, STACK_SIZE
+	code.emit({0xf2, 0x0f, 0x10, 0x25}); code.emit_constant(1.0); // movsd xmm4, [1.0]
+
+	const double* weighting = weightings.data();
+	const double* threshold = thresholds.data();
+	for (unsigned layer=0; layer<=hidden_layers; ++layer) {
+		bool output_layer = (layer == hidden_layers);
+		unsigned int layer_inputs = layer ? hidden_width : input_size;
+		unsigned int output_size = output_layer ? 1 : hidden_width;
+		unsigned int layer_columns = NeuronalNetwork::columns(output_size);
+		uint32_t source = (layer % 2) ? 0 : NN_MAX_SIGNALS * 8;
+		uint32_t destination = (layer % 2) ? NN_MAX_SIGNALS * 8 : 0;
+
+		for (unsigned o=0; o<output_size; ++o) {
+			code.emit({0x66, 0x0f, 0x57, 0xc0});                     // xorpd xmm0, xmm0
+			for (unsigned i=0; i<layer_inputs; ++i) {
+				if (layer) {
+					code.emit({0xf2, 0x0f, 0x10, 0x8c, 0x24});        // movsd xmm1, [rsp+...]
+					code.emit32(source + 8 * i);
+				} else {
+					code.emit({0xf2, 0x0f, 0x10, 0x8f});              // movsd xmm1, [rdi+...]
+					code.emit32(8 * i);
+				}
+				code.emit({0xf2, 0x0f, 0x59, 0x0d});                  // mulsd xmm1, [w]
+				code.emit_constant(weighting[i * layer_columns + o]);
+				code.emit({0xf2, 0x0f, 0x58, 0xc1});                  // addsd xmm0, xmm1
+			}
+			if (output_layer) {
+				code.emit({0x66, 0x0f, 0x2e, 0x05});                  // ucomisd xmm0, [t]
+				code.emit_constant(threshold[o]);
+				code.emit({0x0f, 0x97, 0xc0});                        // seta al
+			} else {
+				code.emit({0xf2, 0x0f, 0x10, 0x1d});                  // movsd xmm3, [t]
+				code.emit_constant(threshold[o]);
+				code.emit({0xf2, 0x0f, 0xc2, 0xd8, 0x01});            // cmpltsd xmm3, xmm0
+				code.emit({0x66, 0x0f, 0x54, 0xdc});                  // andpd xmm3, xmm4
+				code.emit({0xf2, 0x0f, 0x11, 0x9c, 0x24});            // movsd [rsp+...], xmm3
+				code.emit32(destination + 8 * o);
+			}
+		}
+		weighting += layer_inputs * layer_columns;
+		threshold += layer_columns;
+	}
+
+	code.emit({0x48, 0x81, 0xc4}); code.emit32(STACK_SIZE);   // add rsp, STACK_SIZE
+	code.emit({0xc3});                                         // ret
+	code.link();
+}
+
+#endif // NN_JIT
+
+/**
+ * Generates the machine code for the network with the given weightings and thresholds
+ * (in the layout of NeuronalNetwork). Use NetworkCode::get instead, which caches the
+ * programs.
+ */
+NetworkCode::NetworkCode(const unsigned long new_genome_id,
+                         const std::vector<double>& new_weightings,
+                         const std::vector<double>& new_thresholds,
+                         const unsigned int new_input_size,
+                         const unsigned int new_hidden_layers,
+                         const unsigned int new_hidden_width) :
+	genome_id(new_genome_id),
+	weightings(new_weightings),
+	thresholds(new_thresholds),
+	input_size(new_input_size),
+	hidden_layers(new_hidden_layers),
+	hidden_width(new_hidden_width),
+	memory(NULL),
+	memory_size(0),
+	program(NULL)
+{
+	BUG_CHECK(!available(), "No code generation for neuronal networks on this system.");
+#ifdef NN_JIT
+	code_buffer code;
+	generate(code, weightings, thresholds, input_size, hidden_layers, hidden_width);
+
+	memory_size = code.bytes.size();
+	memory = mmap(NULL, memory_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+	              -1, 0);
+	BUG_CHECK(memory == MAP_FAILED, "No memory for neuronal network code.");
+	std::memcpy(memory, code.bytes.data(), memory_size);
+	mprotect(memory, memory_size, PROT_READ | PROT_EXEC);
+	program = reinterpret_cast<bool (*)(const double*)>(memory);
+#endif
+}
+
+/**
+ * Frees the machine code.
+ */
+NetworkCode::~NetworkCode() {
+#ifdef NN_JIT
+	if (memory)
+		munmap(memory, memory_size);
+#endif
+}
+
+/**
+ * Returns true if this is the code for the given network.
+ */
+bool NetworkCode::is_for(const unsigned long other_genome_id,
+                         const std::vector<double>& other_weightings,
+                         const std::vector<double>& other_thresholds,
+                         const unsigned int other_input_size,
+                         const unsigned int other_hidden_layers,
+                         const unsigned int other_hidden_width) const {
+	return genome_id == other_genome_id && input_size == other_input_size &&
+		hidden_layers == other_hidden_layers && hidden_width == other_hidden_width &&
+		weightings == other_weightings && thresholds == other_thresholds;
+}
+
+/**
+ * Returns the machine code for the given network of a genome. If it is not cached yet,
+ * it is generated if the genome has at least NN_JIT_MIN_OFFSPRING offspring. Otherwise
+ * nothing is returned and the network has to be computed without machine code.
+ * This is thread safe.
+ */
+network_code_ptr NetworkCode::get(const unsigned long genome_id, const unsigned int offspring,
+                                  const std::vector<double>& weightings,
+                                  const std::vector<double>& thresholds,
+                                  const unsigned int input_size,
+                                  const unsigned int hidden_layers,
+                                  const unsigned int hidden_width) {
+	static std::mutex cache_mutex;
+	static std::multimap<unsigned long, network_code_ptr> cache;
+	if (!available())
+		return network_code_ptr();
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	auto cached = cache.equal_range(genome_id);
+	for (auto program_i = cached.first; program_i != cached.second; ++program_i)
+		if (program_i->second->is_for(genome_id, weightings, thresholds, input_size,
+		                              hidden_layers, hidden_width))
+			return program_i->second;
+
+	if (offspring < NN_JIT_MIN_OFFSPRING)
+		return network_code_ptr();
+	if (cache.size() >= NN_JIT_MAX_CACHED)
+		cache.clear(); // Programs in use live on in their networks.
+	network_code_ptr program(new NetworkCode(genome_id, weightings, thresholds, input_size,
+	                                         hidden_layers, hidden_width));
+	cache.insert(std::make_pair(genome_id, program));
+	return program;
+}
+
+/**
+ * Returns true if machine code can be generated on this system.
+ */
+bool NetworkCode::available() {
+#ifdef NN_JIT
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,91 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * This file contains the class NetworkCode, machine code generated for one neuronal
+ * network.
+ *
+ */
+
+#ifndef _NETWORK_CODE_H_
+#define _NETWORK_CODE_H_
+
+#include <memory>
+#include <vector>
+#include "debug_macros.h"
+
+/** Build with -DNN_NO_JIT to leave out the code generation. It only exists for x86-64
+    processors on systems with mmap. */
+#if !defined(NN_NO_JIT) && defined(__x86_64__) && defined(__unix__)
+#define NN_JIT
+#endif
+
+/** Genomes with at least this quantity of offspring get machine code for their
+    networks. */
+#define NN_JIT_MIN_OFFSPRING 4
+
+/** If more programs are cached, the cache is emptied. */
+#define NN_JIT_MAX_CACHED 512
+
+class NetworkCode;
+typedef std::shared_ptr<const NetworkCode> network_code_ptr;
+
+/**
+ * Straight-line x86-64 machine code which computes one neuronal network, with the
+ * weightings and thresholds as constants behind the code. It computes the same as the
+ * scalar kernel of NeuronalNetwork, with separate multiplications and additions, so the
+ * decisions are exactly the same.
+ *
+ * Programs are cached by genome id, so a genome which lives through many generations
+ * is compiled only once. All threads share the cache.
+ */
+class NetworkCode {
+public:
+	NetworkCode(const unsigned long new_genome_id, const std::vector<double>& new_weightings,
+	            const std::vector<double>& new_thresholds, const unsigned int new_input_size,
+	            const unsigned int new_hidden_layers, const unsigned int new_hidden_width);
+	~NetworkCode();
+	NetworkCode(const NetworkCode&) = delete;
+	NetworkCode& operator=(const NetworkCode&) = delete;
+
+	/** Computes the network for the given input signals and returns the decision. */
+	inline bool decide(const double* signals) const { return program(signals); }
+
+	static network_code_ptr get(const unsigned long genome_id, const unsigned int offspring,
+	                            const std::vector<double>& weightings,
+	                            const std::vector<double>& thresholds,
+	                            const unsigned int input_size,
+	                            const unsigned int hidden_layers,
+	                            const unsigned int hidden_width);
+	static bool available();
+
+private:
+	bool is_for(const unsigned long other_genome_id,
+	            const std::vector<double>& other_weightings,
+	            const std::vector<double>& other_thresholds,
+	            const unsigned int other_input_size,
+	            const unsigned int other_hidden_layers,
+	            const unsigned int other_hidden_width) const;
+
+	/** Id of the genome the network belongs to. */
+	unsigned long genome_id;
+	/** The weightings the code was made for. */
+	std::vector<double> weightings;
+	/** The thresholds the code was made for. */
+	std::vector<double> thresholds;
+	/** Quantity of input signals. */
+	unsigned int input_size;
+	/** Quantity of hidden layers. */
+	unsigned int hidden_layers;
+	/** Quantity of output signals of every hidden layer. */
+	unsigned int hidden_width;
+	/** The executable memory. */
+	void* memory;
+	/** Size of the executable memory. */
+	size_t memory_size;
+	/** The generated function. */
+	bool (*program)(const double* signals);
+};
+
+#endif // _NETWORK_CODE_H_
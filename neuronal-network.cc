@@ -0,0 +1,810 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+#include "neuronal-network.h"
+#include "genome.h"
+#include "fly.h"
+#include "wasp.h"
+
+#ifdef NN_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/**
+ * One hidden layer of fixed_network with INPUTS input signals and WIDTH outputs. The
+ * output signals replace the input signals in layer_signals.
+ */
+template<unsigned int INPUTS, unsigned int WIDTH, std::size_t SIGNALS>
+static inline void fixed_layer(std::array<double, SIGNALS>& layer_signals,
+                               const double* weighting, const double* threshold) {
+	constexpr unsigned int COLUMNS = (WIDTH + NN_LANES - 1) / NN_LANES * NN_LANES;
+	std::array<double, COLUMNS> signal_sums;
+	signal_sums.fill(0.0);
+#pragma GCC unroll 16
+	for (unsigned i=0; i<INPUTS; ++i)
+#pragma GCC unroll 16
+		for (unsigned o=0; o<COLUMNS; ++o)
+			signal_sums[o] += layer_signals[i] * weighting[i * COLUMNS + o];
+#pragma GCC unroll 16
+	for (unsigned o=0; o<WIDTH; ++o)
+		layer_signals[o] = (signal_sums[o] > threshold[o]);
+}
+
+/**
+ * A network with INPUTS input signals and HIDDEN_LAYERS hidden layers of WIDTH outputs,
+ * computed with sizes known at compile time. It uses the weightings and thresholds in the
+ * layout of NeuronalNetwork and sums up in the same order as the scalar kernel, but all
+ * loops are unrolled and the signals are kept in std::arrays.
+ */
+template<unsigned int INPUTS, unsigned int WIDTH, unsigned int HIDDEN_LAYERS>
+static void fixed_network(const double* weightings, const double* thresholds,
+                          const double* signals, const unsigned int quantity,
+                          bool* decisions) {
+	constexpr unsigned int COLUMNS = (WIDTH + NN_LANES - 1) / NN_LANES * NN_LANES;
+	constexpr unsigned int OUTPUT_INPUTS = HIDDEN_LAYERS ? WIDTH : INPUTS;
+
+	for (unsigned n=0; n<quantity; ++n) {
+		std::array<double, (INPUTS > WIDTH) ? INPUTS : WIDTH> layer_signals;
+		std::copy(&signals[n * INPUTS], &signals[(n + 1) * INPUTS], layer_signals.begin());
+		const double* weighting = weightings;
+		const double* threshold = thresholds;
+
+		if (HIDDEN_LAYERS) {
+			fixed_layer<INPUTS, WIDTH>(layer_signals, weighting, threshold);
+			weighting += INPUTS * COLUMNS;
+			threshold += COLUMNS;
+		}
+		for (unsigned layer=1; layer<HIDDEN_LAYERS; ++layer) {
+			fixed_layer<WIDTH, WIDTH>(layer_signals, weighting, threshold);
+			weighting += WIDTH * COLUMNS;
+			threshold += COLUMNS;
+		}
+
+		// The output layer has one signal in its first column.
+		double signal_sum = 0.0;
+#pragma GCC unroll 16
+		for (unsigned i=0; i<OUTPUT_INPUTS; ++i)
+			signal_sum += layer_signals[i] * weighting[i * NN_LANES];
+		decisions[n] = (signal_sum > threshold[0]);
+	}
+}
+
+/** The networks with fixed topology for INPUTS input signals and hidden layers of WIDTH
+    outputs, one per quantity of hidden layers from 0 to NN_FIXED_MAX_HIDDEN_LAYERS. */
+template<unsigned int INPUTS, unsigned int WIDTH, unsigned int... HIDDEN_LAYERS>
+static constexpr std::array<fixed_network_function, sizeof...(HIDDEN_LAYERS)>
+fixed_networks(std::integer_sequence<unsigned int, HIDDEN_LAYERS...>) {
+	return {{fixed_network<INPUTS, WIDTH, HIDDEN_LAYERS>...}};
+}
+
+/**
+ * One entry of the table of networks with fixed topology.
+ */
+struct fixed_topologies {
+	/** Quantity of input signals. */
+	unsigned int input_size;
+	/** Quantity of outputs of the hidden layers. */
+	unsigned int hidden_width;
+	/** The networks, indexed by the quantity of hidden layers. */
+	std::array<fixed_network_function, NN_FIXED_MAX_HIDDEN_LAYERS + 1> networks;
+};
+
+/** Hidden layer quantities of the table. */
+typedef std::make_integer_sequence<unsigned int, NN_FIXED_MAX_HIDDEN_LAYERS + 1> fixed_layers;
+
+/** Networks with fixed topology exist for these sizes: the ones of Fly and Wasp with full
+    width hidden layers, and the one of Wasp with WASP_NN_NARROW_WIDTH.
+    Other networks are computed by the layer kernels. */
+static const fixed_topologies fixed_topology_table[] = {
+	{FLY_NN_INPUTS, FLY_NN_INPUTS,
+	 fixed_networks<FLY_NN_INPUTS, FLY_NN_INPUTS>(fixed_layers())},
+	{WASP_NN_INPUTS, WASP_NN_INPUTS,
+	 fixed_networks<WASP_NN_INPUTS, WASP_NN_INPUTS>(fixed_layers())},
+	{WASP_NN_INPUTS, WASP_NN_NARROW_WIDTH,
+	 fixed_networks<WASP_NN_INPUTS, WASP_NN_NARROW_WIDTH>(fixed_layers())}
+};
+
+/**
+ * Returns the network with fixed topology for the given sizes, or NULL if there is none.
+ */
+static fixed_network_function find_fixed_network(const unsigned int input_size,
+                                                 const unsigned int hidden_layers,
+                                                 const unsigned int hidden_width) {
+	if (hidden_layers > NN_FIXED_MAX_HIDDEN_LAYERS)
+		return NULL;
+	for (auto const& topologies: fixed_topology_table)
+		if (topologies.input_size == input_size && topologies.hidden_width == hidden_width)
+			return topologies.networks[hidden_layers];
+	return NULL;
+}
+
+/**
+ * Converts a signal or weighting of range -1..1 to the signal type of a reduced
+ * precision network. float takes it as it is, signed char as a fixed point number with
+ * NN_INT8_ONE as 1.0.
+ */
+template<class signal_type> static signal_type reduce(double val);
+
+template<> float reduce<float>(double val) {
+	return val;
+}
+
+template<> signed char reduce<signed char>(double val) {
+	val = std::max(-1.0, std::min(1.0, val));
+	return std::lround(val * NN_INT8_ONE);
+}
+
+/**
+ * Computes a network with reduced precision. The weightings and thresholds have the
+ * layout of NeuronalNetwork, but the types signal_type and sum_type. An active neuron
+ * has the output signal one.
+ */
+template<class signal_type, class sum_type>
+static void reduced_network(const signal_type* weightings, const sum_type* thresholds,
+                            const unsigned int input_size, const unsigned int hidden_layers,
+                            const unsigned int hidden_width,
+                            const signal_type one, const double* signals,
+                            const unsigned int quantity, bool* decisions) {
+	for (unsigned n=0; n<quantity; ++n) {
+		signal_type layer_signals[NN_MAX_SIGNALS];
+		for (unsigned i=0; i<input_size; ++i)
+			layer_signals[i] = reduce<signal_type>(signals[n * input_size + i]);
+		const signal_type* weighting = weightings;
+		const sum_type* threshold = thresholds;
+
+		for (unsigned layer=0; layer<=hidden_layers; ++layer) {
+			unsigned int layer_inputs = layer ? hidden_width : input_size;
+			unsigned int layer_columns = (layer == hidden_layers) ? NN_LANES :
+				(hidden_width + NN_LANES - 1) / NN_LANES * NN_LANES;
+			sum_type signal_sums[NN_MAX_SIGNALS] = {};
+			for (unsigned i=0; i<layer_inputs; ++i)
+				for (unsigned o=0; o<layer_columns; ++o)
+					signal_sums[o] += (sum_type)layer_signals[i] *
+						(sum_type)weighting[i * layer_columns + o];
+			if (layer == hidden_layers)
+				decisions[n] = (signal_sums[0] > threshold[0]);
+			else
+				for (unsigned o=0; o<hidden_width; ++o)
+					layer_signals[o] = (signal_sums[o] > threshold[o]) ? one : 0;
+			weighting += layer_inputs * layer_columns;
+			threshold += layer_columns;
+		}
+	}
+}
+
+/**
+ * Compiles the network from the genes of the given genome, starting with gene number
+ * new_first_gene. The hidden layers get new_hidden_width outputs, or as many as the
+ * network has inputs if it is zero. The genes are read in the same order as the network
+ * uses them: per layer and output signal the weightings of all input signals of the
+ * layer and then the threshold. So the quantity of genes follows the topology.
+ * Missing genes are created by the genome (see Genome::get_gene).
+ * Every layer is stored as a matrix with one row per input signal and one column per
+ * output signal. The quantity of columns is rounded up to NN_LANES, the additional
+ * columns have zero weightings and thresholds.
+ */
+NeuronalNetwork::NeuronalNetwork(Genome& genome, const unsigned int new_first_gene,
+                                 const unsigned int new_input_size,
+                                 const unsigned int new_hidden_layers,
+                                 const unsigned int new_hidden_width) :
+	first_gene(new_first_gene),
+	input_size(new_input_size),
+	hidden_layers(new_hidden_layers),
+	hidden_width(new_hidden_width ? new_hidden_width : new_input_size)
+{
+	BUG_CHECK(!input_size, "Empty input signals container makes no sense.");
+	BUG_CHECK(input_size>NN_MAX_SIGNALS, "Too many input signals for neuronal network: "
+	          << input_size);
+	BUG_CHECK(hidden_layers>100, "Too many hidden layers in neuronal network.");
+	BUG_CHECK(hidden_width>NN_MAX_SIGNALS, "Too wide hidden layers in neuronal network: "
+	          << hidden_width);
+	unsigned int weighting_quantity = 0;
+	unsigned int threshold_quantity = 0;
+	for (unsigned layer=0; layer<=hidden_layers; ++layer) {
+		weighting_quantity += inputs_of(layer) * columns(outputs_of(layer));
+		threshold_quantity += columns(outputs_of(layer));
+	}
+	weightings.assign(weighting_quantity, 0.0);
+	thresholds.assign(threshold_quantity, 0.0);
+
+	unsigned int next_gene = first_gene;
+	double* weighting = weightings.data();
+	double* threshold = thresholds.data();
+	for (unsigned layer=0; layer<=hidden_layers; ++layer) {
+		unsigned int layer_columns = columns(outputs_of(layer));
+		for (unsigned o=0; o<outputs_of(layer); ++o) {
+			for (unsigned i=0; i<inputs_of(layer); ++i)
+				weighting[i * layer_columns + o] = scale(genome.get_gene(next_gene++));
+			threshold[o] = genome.get_gene(next_gene++);
+		}
+		weighting += inputs_of(layer) * layer_columns;
+		threshold += layer_columns;
+	}
+	gene_quantity = next_gene - first_gene;
+	fixed_topology = find_fixed_network(input_size, hidden_layers, hidden_width);
+	network_precision = precision;
+	reduce_weightings();
+	serial = next_serial++;
+	if (jit_used)
+		code = NetworkCode::get(genome.get_genome_id(), genome.get_offspring_quantity(),
+		                        weightings, thresholds, input_size, hidden_layers,
+		                        hidden_width);
+}
+
+/**
+ * Converts the weightings and thresholds for the precision of this network, if it is a
+ * reduced one. This is done in the constructor, so the network does not change later.
+ */
+void NeuronalNetwork::reduce_weightings() {
+	if (network_precision == NN_PRECISION_FLOAT) {
+		float_weightings.reserve(weightings.size());
+		for (auto const& weighting: weightings)
+			float_weightings.push_back(reduce<float>(weighting));
+		float_thresholds.assign(thresholds.begin(), thresholds.end());
+	} else if (network_precision == NN_PRECISION_INT8) {
+		int8_weightings.reserve(weightings.size());
+		for (auto const& weighting: weightings)
+			int8_weightings.push_back(reduce<signed char>(weighting));
+		int8_thresholds.reserve(thresholds.size());
+		for (auto const& threshold: thresholds)
+			int8_thresholds.push_back(std::lround(threshold * NN_INT8_ONE * NN_INT8_ONE));
+	}
+}
+
+/**
+ * Computes the network for the given input signals (as many as the network has inputs)
+ * and returns the binary decision. See NeuronalNetwork::decide_batch.
+ */
+bool NeuronalNetwork::decide(const double* signals) const {
+	bool decision;
+	decide_batch(signals, 1, &decision);
+	return decision;
+}
+
+/**
+ * Computes the network for quantity input vectors at once. The signals of the first one
+ * are at signals[0] and following, the next one starts right behind and so on. The
+ * decision for every input vector is written to decisions.
+ * If the decision cache is switched on (see NeuronalNetwork::set_cache_step), only the
+ * input vectors which are not found in the cache of this thread are computed.
+ */
+void NeuronalNetwork::decide_batch(const double* signals, const unsigned int quantity,
+                                   bool* decisions) const {
+	if (cache_step <= 0.0) {
+		decide_uncached(signals, quantity, decisions);
+		return;
+	}
+	if (!thread_cache)
+		thread_cache.reset(new cache_entry[NN_CACHE_SIZE]);
+	cache_entry* cache = thread_cache.get();
+
+	unsigned long hits = 0;
+	for (unsigned first=0; first<quantity; first+=NN_BATCH_SIZE) {
+		unsigned int part = std::min(quantity - first, (unsigned int)NN_BATCH_SIZE);
+		double miss_signals[NN_BATCH_SIZE * NN_MAX_SIGNALS];
+		unsigned int miss_positions[NN_BATCH_SIZE];
+		unsigned long long miss_keys[NN_BATCH_SIZE];
+		bool miss_decisions[NN_BATCH_SIZE];
+		unsigned int misses = 0;
+
+		for (unsigned n=first; n<first+part; ++n) {
+			const double* vector_signals = &signals[n * input_size];
+			unsigned long long key = cache_key(vector_signals);
+			cache_entry* entry = &cache[(key ^ serial * 0x9e3779b97f4a7c15ull) % NN_CACHE_SIZE];
+			if (entry->key == key && entry->network_serial == serial) {
+				decisions[n] = entry->decision;
+				++hits;
+			} else {
+				std::copy(vector_signals, vector_signals + input_size,
+				          &miss_signals[misses * input_size]);
+				miss_positions[misses] = n;
+				miss_keys[misses++] = key;
+			}
+		}
+
+		decide_uncached(miss_signals, misses, miss_decisions);
+		for (unsigned m=0; m<misses; ++m) {
+			cache_entry& entry =
+				cache[(miss_keys[m] ^ serial * 0x9e3779b97f4a7c15ull) % NN_CACHE_SIZE];
+			entry.network_serial = serial;
+			entry.key = miss_keys[m];
+			entry.decision = miss_decisions[m];
+			decisions[miss_positions[m]] = miss_decisions[m];
+		}
+	}
+	cache_hits += hits;
+	cache_misses += quantity - hits;
+}
+
+/**
+ * Returns the key of the given input signals in the decision cache. Every signal is
+ * rounded to a multiple of the cache step, and the results are hashed. Zero is never
+ * returned, it marks empty cache entries.
+ */
+unsigned long long NeuronalNetwork::cache_key(const double* signals) const {
+	unsigned long long key = 14695981039346656037ull;
+	for (unsigned i=0; i<input_size; ++i) {
+		key ^= (unsigned long long)std::llround(signals[i] / cache_step);
+		key *= 1099511628211ull;
+	}
+	key ^= key >> 29;
+	return key ? key : 1;
+}
+
+/**
+ * Computes the network like NeuronalNetwork::decide_batch, but without the cache. The
+ * network is computed with the precision which was chosen by
+ * NeuronalNetwork::set_precision when it was made.
+ * If validation is switched on, every decision of a reduced precision is compared with
+ * the one in full precision (see NeuronalNetwork::set_validation).
+ */
+void NeuronalNetwork::decide_uncached(const double* signals, const unsigned int quantity,
+                                      bool* decisions) const {
+	switch (network_precision) {
+	case NN_PRECISION_FLOAT:
+		reduced_network(float_weightings.data(), float_thresholds.data(), input_size,
+		                hidden_layers, hidden_width, 1.0f, signals, quantity, decisions);
+		break;
+	case NN_PRECISION_INT8:
+		reduced_network(int8_weightings.data(), int8_thresholds.data(), input_size,
+		                hidden_layers, hidden_width, (signed char)NN_INT8_ONE, signals,
+		                quantity, decisions);
+		break;
+	default:
+		decide_exactly(signals, quantity, decisions);
+		return;
+	}
+
+	if (validating)
+		validate(signals, quantity, decisions);
+}
+
+/**
+ * Compares the given decisions with the ones in full precision for the same input
+ * signals and counts the differences.
+ */
+void NeuronalNetwork::validate(const double* signals, const unsigned int quantity,
+                               const bool* decisions) const {
+	unsigned long mismatches = 0;
+	bool exact_decisions[NN_BATCH_SIZE];
+	for (unsigned first=0; first<quantity; first+=NN_BATCH_SIZE) {
+		unsigned int part = std::min(quantity - first, (unsigned int)NN_BATCH_SIZE);
+		decide_exactly(&signals[first * input_size], part, exact_decisions);
+		for (unsigned n=0; n<part; ++n)
+			mismatches += (exact_decisions[n] != decisions[first + n]);
+	}
+	validated_decisions += quantity;
+	decision_mismatches += mismatches;
+}
+
+/**
+ * Computes the network in full (double) precision, see NeuronalNetwork::decide_batch.
+ * Networks with machine code are computed by it. Networks of the usual sizes are
+ * computed by code made for exactly their topology, which sums up in the same order as
+ * the layer kernels, with any kernel.
+ * Otherwise every layer is computed by the layer kernel for up to NN_BATCH_SIZE input
+ * vectors in a row, so its weightings are used for all of them while they are in the
+ * cache.
+ */
+void NeuronalNetwork::decide_exactly(const double* signals, const unsigned int quantity,
+                                     bool* decisions) const {
+	if (code) {
+		for (unsigned n=0; n<quantity; ++n)
+			decisions[n] = code->decide(&signals[n * input_size]);
+		return;
+	}
+	if (fixed_topology && fixed_topologies_used) {
+		fixed_topology(weightings.data(), thresholds.data(), signals, quantity, decisions);
+		return;
+	}
+	alignas(64) double layer_signals[2][NN_BATCH_SIZE * NN_MAX_SIGNALS];
+
+	for (unsigned first=0; first<quantity; first+=NN_BATCH_SIZE) {
+		unsigned int part = std::min(quantity - first, (unsigned int)NN_BATCH_SIZE);
+		const double* input_signals = &signals[first * input_size];
+		unsigned int input_stride = input_size;
+		double* output_signals = layer_signals[0];
+		const double* weighting = weightings.data();
+		const double* threshold = thresholds.data();
+
+		for (unsigned layer=0; layer<=hidden_layers; ++layer) {
+			unsigned int layer_columns = columns(outputs_of(layer));
+			layer_kernel(input_signals, input_stride, inputs_of(layer), part, weighting,
+			             threshold, layer_columns, output_signals, NN_MAX_SIGNALS);
+			weighting += inputs_of(layer) * layer_columns;
+			threshold += layer_columns;
+			input_signals = output_signals;
+			input_stride = NN_MAX_SIGNALS;
+			output_signals = (output_signals == layer_signals[0]) ?
+				layer_signals[1] : layer_signals[0];
+		}
+
+		for (unsigned n=0; n<part; ++n)
+			decisions[first + n] = input_signals[n * NN_MAX_SIGNALS] > 0.5;
+	}
+}
+
+/**
+ * Computes the network for the given input signals like NeuronalNetwork::decide, but
+ * with the help of the state of the last computation for the same agent. The sums of
+ * the first layer are only changed by the weighted differences of the input signals
+ * which changed, and the other layers are only computed if an output of the first layer
+ * changed. The state is updated.
+ * Because of rounding, the sums differ a little from the ones of a complete
+ * computation. That's why every NN_FULL_UPDATE_INTERVAL computations (and for a state
+ * which does not belong to this network) the sums are computed completely.
+ */
+bool NeuronalNetwork::decide_incrementally(const double* signals, nn_state& state) const {
+	unsigned int first_size = outputs_of(0);
+	unsigned int first_columns = columns(first_size);
+	bool complete = state.network_serial != serial || !state.updates_left;
+
+	if (complete) {
+		for (unsigned o=0; o<first_size; ++o) {
+			double signal_sum = 0.0;
+			for (unsigned i=0; i<input_size; ++i)
+				signal_sum += signals[i] * weightings[i * first_columns + o];
+			state.signal_sums[o] = signal_sum;
+		}
+		state.network_serial = serial;
+		state.updates_left = NN_FULL_UPDATE_INTERVAL;
+	} else {
+		for (unsigned i=0; i<input_size; ++i)
+			if (signals[i] != state.signals[i]) {
+				double difference = signals[i] - state.signals[i];
+				for (unsigned o=0; o<first_size; ++o)
+					state.signal_sums[o] += difference * weightings[i * first_columns + o];
+			}
+		--state.updates_left;
+	}
+	std::copy(signals, signals + input_size, state.signals);
+
+	unsigned int outputs = 0;
+	for (unsigned o=0; o<first_size; ++o)
+		if (state.signal_sums[o] > thresholds[o])
+			outputs |= 1u << o;
+	if (!complete && outputs == state.outputs)
+		return state.decision;
+	state.outputs = outputs;
+
+	// The other layers, computed from the outputs of the first one.
+	alignas(64) double layer_signals[2][NN_MAX_SIGNALS];
+	for (unsigned o=0; o<first_size; ++o)
+		layer_signals[0][o] = (outputs >> o) & 1u;
+	const double* input_signals = layer_signals[0];
+	double* output_signals = layer_signals[1];
+	const double* weighting = &weightings[input_size * first_columns];
+	const double* threshold = &thresholds[first_columns];
+	for (unsigned layer=1; layer<=hidden_layers; ++layer) {
+		unsigned int layer_columns = columns(outputs_of(layer));
+		layer_kernel(input_signals, NN_MAX_SIGNALS, inputs_of(layer), 1, weighting,
+		             threshold, layer_columns, output_signals, NN_MAX_SIGNALS);
+		weighting += inputs_of(layer) * layer_columns;
+		threshold += layer_columns;
+		input_signals = output_signals;
+		output_signals = (output_signals == layer_signals[0]) ?
+			layer_signals[1] : layer_signals[0];
+	}
+
+	state.decision = input_signals[0] > 0.5;
+	return state.decision;
+}
+
+/**
+ * Returns true if this network was compiled for the given gene position and topology,
+ * and for the precision chosen now. A hidden width of zero means as wide as the input,
+ * like in the constructor.
+ */
+bool NeuronalNetwork::fits(const unsigned int other_first_gene,
+                           const unsigned int other_input_size,
+                           const unsigned int other_hidden_layers,
+                           const unsigned int other_hidden_width) const {
+	return first_gene == other_first_gene && input_size == other_input_size &&
+		hidden_layers == other_hidden_layers &&
+		hidden_width == (other_hidden_width ? other_hidden_width : other_input_size) &&
+		network_precision == precision;
+}
+
+/**
+ * The plain C++ layer kernel. It computes one layer for quantity input vectors, the
+ * first at input_signals, the next input_stride doubles behind and so on. The outputs
+ * are written the same way with output_stride. For every output signal (column) it
+ * sums up the weighted input signals and compares the sum with the threshold.
+ * All other kernels compute the same, NN_LANES or fewer columns at once, and sum up in
+ * the same order. They multiply and add separately like this one (no FMA), so all
+ * kernels give exactly the same decisions.
+ */
+static void scalar_layer(const double* input_signals, const unsigned int input_stride,
+                         const unsigned int input_size, const unsigned int quantity,
+                         const double* weightings, const double* thresholds,
+                         const unsigned int layer_columns, double* output_signals,
+                         const unsigned int output_stride) {
+	for (unsigned n=0; n<quantity; ++n) {
+		const double* inputs = &input_signals[n * input_stride];
+		double* outputs = &output_signals[n * output_stride];
+		for (unsigned o=0; o<layer_columns; ++o) {
+			double signal_sum = 0.0;
+			for (unsigned i=0; i<input_size; ++i)
+				signal_sum += inputs[i] * weightings[i * layer_columns + o];
+			outputs[o] = (signal_sum > thresholds[o]);
+		}
+	}
+}
+
+#ifdef NN_X86_KERNELS
+
+/**
+ * Layer kernel for SSE2, two columns at once.
+ */
+__attribute__((target("sse2")))
+static void sse2_layer(const double* input_signals, const unsigned int input_stride,
+                       const unsigned int input_size, const unsigned int quantity,
+                       const double* weightings, const double* thresholds,
+                       const unsigned int layer_columns, double* output_signals,
+                       const unsigned int output_stride) {
+	const __m128d ones = _mm_set1_pd(1.0);
+	for (unsigned n=0; n<quantity; ++n) {
+		const double* inputs = &input_signals[n * input_stride];
+		double* outputs = &output_signals[n * output_stride];
+		for (unsigned o=0; o<layer_columns; o+=2) {
+			__m128d signal_sum = _mm_setzero_pd();
+			for (unsigned i=0; i<input_size; ++i)
+				signal_sum = _mm_add_pd(signal_sum,
+				                        _mm_mul_pd(_mm_set1_pd(inputs[i]),
+				                                   _mm_loadu_pd(&weightings[i * layer_columns + o])));
+			__m128d over = _mm_cmpgt_pd(signal_sum, _mm_loadu_pd(&thresholds[o]));
+			_mm_storeu_pd(&outputs[o], _mm_and_pd(over, ones));
+		}
+	}
+}
+
+/**
+ * Layer kernel for AVX2, four columns at once.
+ */
+__attribute__((target("avx2")))
+static void avx2_layer(const double* input_signals, const unsigned int input_stride,
+                       const unsigned int input_size, const unsigned int quantity,
+                       const double* weightings, const double* thresholds,
+                       const unsigned int layer_columns, double* output_signals,
+                       const unsigned int output_stride) {
+	const __m256d ones = _mm256_set1_pd(1.0);
+	for (unsigned n=0; n<quantity; ++n) {
+		const double* inputs = &input_signals[n * input_stride];
+		double* outputs = &output_signals[n * output_stride];
+		for (unsigned o=0; o<layer_columns; o+=4) {
+			__m256d signal_sum = _mm256_setzero_pd();
+			for (unsigned i=0; i<input_size; ++i)
+				signal_sum = _mm256_add_pd(signal_sum,
+				                           _mm256_mul_pd(_mm256_set1_pd(inputs[i]),
+				                                         _mm256_loadu_pd(&weightings[i * layer_columns + o])));
+			__m256d over = _mm256_cmp_pd(signal_sum, _mm256_loadu_pd(&thresholds[o]),
+			                             _CMP_GT_OQ);
+			_mm256_storeu_pd(&outputs[o], _mm256_and_pd(over, ones));
+		}
+	}
+}
+
+/**
+ * Layer kernel for AVX-512, eight columns at once. AVX-512F has FMA instructions, so
+ * the compiler must not contract the multiplications and additions.
+ */
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static void avx512_layer(const double* input_signals, const unsigned int input_stride,
+                         const unsigned int input_size, const unsigned int quantity,
+                         const double* weightings, const double* thresholds,
+                         const unsigned int layer_columns, double* output_signals,
+                         const unsigned int output_stride) {
+	const __m512d ones = _mm512_set1_pd(1.0);
+	for (unsigned n=0; n<quantity; ++n) {
+		const double* inputs = &input_signals[n * input_stride];
+		double* outputs = &output_signals[n * output_stride];
+		for (unsigned o=0; o<layer_columns; o+=8) {
+			__m512d signal_sum = _mm512_setzero_pd();
+			for (unsigned i=0; i<input_size; ++i)
+				signal_sum = _mm512_add_pd(signal_sum,
+				                           _mm512_mul_pd(_mm512_set1_pd(inputs[i]),
+				                                         _mm512_loadu_pd(&weightings[i * layer_columns + o])));
+			__mmask8 over = _mm512_cmp_pd_mask(signal_sum, _mm512_loadu_pd(&thresholds[o]),
+			                                   _CMP_GT_OQ);
+			_mm512_storeu_pd(&outputs[o], _mm512_maskz_mov_pd(over, ones));
+		}
+	}
+}
+
+#endif // NN_X86_KERNELS
+
+/**
+ * Returns true if the processor this program runs on can use the given kernel.
+ */
+bool NeuronalNetwork::kernel_available(const nn_kernel kernel) {
+#ifdef NN_X86_KERNELS
+	__builtin_cpu_init();
+#endif
+	switch (kernel) {
+	case NN_KERNEL_SCALAR:
+		return true;
+#ifdef NN_X86_KERNELS
+	case NN_KERNEL_SSE2:
+		return __builtin_cpu_supports("sse2");
+	case NN_KERNEL_AVX2:
+		return __builtin_cpu_supports("avx2");
+	case NN_KERNEL_AVX512:
+		return __builtin_cpu_supports("avx512f");
+#endif
+	default:
+		return false;
+	}
+}
+
+/**
+ * Chooses the kernel which computes the layers of all neuronal networks. Returns false
+ * (and changes nothing) if the processor can not use it. All kernels give the same
+ * decisions.
+ */
+bool NeuronalNetwork::set_kernel(const nn_kernel kernel) {
+	if (!kernel_available(kernel))
+		return false;
+	switch (kernel) {
+#ifdef NN_X86_KERNELS
+	case NN_KERNEL_SSE2:
+		layer_kernel = sse2_layer;
+		break;
+	case NN_KERNEL_AVX2:
+		layer_kernel = avx2_layer;
+		break;
+	case NN_KERNEL_AVX512:
+		layer_kernel = avx512_layer;
+		break;
+#endif
+	default:
+		layer_kernel = scalar_layer;
+	}
+	chosen_kernel = kernel;
+	return true;
+}
+
+/**
+ * Returns the kernel which computes the layers of all neuronal networks.
+ */
+nn_kernel NeuronalNetwork::get_kernel() {
+	return chosen_kernel;
+}
+
+/**
+ * Returns the fastest kernel the processor can use.
+ */
+nn_kernel NeuronalNetwork::best_kernel() {
+	if (kernel_available(NN_KERNEL_AVX512))
+		return NN_KERNEL_AVX512;
+	if (kernel_available(NN_KERNEL_AVX2))
+		return NN_KERNEL_AVX2;
+	if (kernel_available(NN_KERNEL_SSE2))
+		return NN_KERNEL_SSE2;
+	return NN_KERNEL_SCALAR;
+}
+
+/**
+ * Switches the use of the networks with fixed topology on or off. If it is off, all
+ * networks are computed by the layer kernel. It is on at start, whatever kernel is
+ * chosen.
+ */
+void NeuronalNetwork::use_fixed_topologies(const bool use) {
+	fixed_topologies_used = use;
+}
+
+/**
+ * Chooses the precision of all neuronal networks. Reduced precisions are faster, but
+ * sometimes lead to other decisions than full precision. The networks made before are
+ * made again at their next use (see NeuronalNetwork::fits).
+ */
+void NeuronalNetwork::set_precision(const nn_precision new_precision) {
+	precision = new_precision;
+}
+
+/**
+ * Returns the precision of all neuronal networks.
+ */
+nn_precision NeuronalNetwork::get_precision() {
+	return precision;
+}
+
+/**
+ * Switches the validation of reduced precision decisions on or off. While it is on, all
+ * networks are additionally computed in full precision and the differing decisions are
+ * counted. Switching it on resets the counters.
+ */
+void NeuronalNetwork::set_validation(const bool validate) {
+	if (validate) {
+		validated_decisions = 0;
+		decision_mismatches = 0;
+	}
+	validating = validate;
+}
+
+/**
+ * Returns the quantity of decisions compared with full precision since the validation
+ * was switched on.
+ */
+unsigned long NeuronalNetwork::get_validated_decisions() {
+	return validated_decisions;
+}
+
+/**
+ * Returns the quantity of decisions which differed from full precision since the
+ * validation was switched on.
+ */
+unsigned long NeuronalNetwork::get_decision_mismatches() {
+	return decision_mismatches;
+}
+
+/**
+ * Switches the decision cache of all networks on (with a positive step) or off (with
+ * zero). With the cache, every thread remembers the decisions of the networks for input
+ * signals rounded to multiples of the step, and takes them again for similar input
+ * signals instead of computing. So the bigger the step, the more often the cache is
+ * used, but the less exact the decisions are. Which decisions a thread remembers depends
+ * on the worlds it computed before, so with several threads the results of runs vary.
+ * Switching resets the counters of hits and misses.
+ */
+void NeuronalNetwork::set_cache_step(const double new_step) {
+	BUG_CHECK(new_step<0.0, "Negative decision cache step: " << new_step);
+	cache_step = new_step;
+	cache_hits = 0;
+	cache_misses = 0;
+}
+
+/**
+ * Returns the step of the decision cache, zero if it is off.
+ */
+double NeuronalNetwork::get_cache_step() {
+	return cache_step;
+}
+
+/**
+ * Returns the quantity of decisions taken from the cache since it was switched on.
+ */
+unsigned long NeuronalNetwork::get_cache_hits() {
+	return cache_hits;
+}
+
+/**
+ * Returns the quantity of decisions computed with the cache switched on.
+ */
+unsigned long NeuronalNetwork::get_cache_misses() {
+	return cache_misses;
+}
+
+/**
+ * Switches the generation of machine code for networks on or off. It works for
+ * networks compiled afterwards, and only if it is built in (see NN_JIT). Returns false
+ * if it is not.
+ */
+bool NeuronalNetwork::set_jit(const bool use) {
+	jit_used = use && NetworkCode::available();
+	return jit_used == use;
+}
+
+NeuronalNetwork::layer_function NeuronalNetwork::layer_kernel = scalar_layer;
+nn_kernel NeuronalNetwork::chosen_kernel = NN_KERNEL_SCALAR;
+bool NeuronalNetwork::fixed_topologies_used = true;
+bool NeuronalNetwork::jit_used = false;
+nn_precision NeuronalNetwork::precision = NN_PRECISION_DOUBLE;
+bool NeuronalNetwork::validating = false;
+std::atomic<unsigned long> NeuronalNetwork::validated_decisions(0);
+std::atomic<unsigned long> NeuronalNetwork::decision_mismatches(0);
+double NeuronalNetwork::cache_step = 0.0;
+std::atomic<unsigned long> NeuronalNetwork::next_serial(1);
+std::atomic<unsigned long> NeuronalNetwork::cache_hits(0);
+std::atomic<unsigned long> NeuronalNetwork::cache_misses(0);
+thread_local std::unique_ptr<NeuronalNetwork::cache_entry[]> NeuronalNetwork::thread_cache;
+
+/** Chooses the best kernel when the program starts. */
+static const bool best_kernel_chosen = NeuronalNetwork::set_kernel(NeuronalNetwork::best_kernel());
@@ -0,0 +1,248 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * This file contains the class NeuronalNetwork, the compiled phenotype of a genome.
+ *
+ */
+
+#ifndef _NEURONAL_NETWORK_H_
+#define _NEURONAL_NETWORK_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "debug_macros.h"
+#include "network-code.h"
+
+/** Maximum quantity of signals in one layer of a neuronal network (see
+    Agent::neuronal_network). Must be a multiple of NN_LANES. */
+#define NN_MAX_SIGNALS 16
+
+/** The layers of a network are stored with a multiple of this quantity of output
+    signals, the widest SIMD kernel computes that many at once. */
+#define NN_LANES 8
+
+/** Networks with up to this quantity of hidden layers can have a fixed topology (see
+    NeuronalNetwork::decide_batch). */
+#define NN_FIXED_MAX_HIDDEN_LAYERS 9
+
+/** Quantity of input vectors NeuronalNetwork::decide_batch computes together. */
+#define NN_BATCH_SIZE 32
+
+/** Quantity of entries in the decision cache of a thread, which all networks share. */
+#define NN_CACHE_SIZE 65536
+
+/** After this many incremental computations the first layer of a network is computed
+    completely again (see NeuronalNetwork::decide_incrementally). */
+#define NN_FULL_UPDATE_INTERVAL 64
+
+/** The signal value 1.0 in networks with NN_PRECISION_INT8. */
+#define NN_INT8_ONE 127
+
+#if defined(__x86_64__) || defined(__i386__)
+/** Defined if the SSE2, AVX2 and AVX-512 kernels are compiled in. */
+#define NN_X86_KERNELS
+#endif
+
+/**
+ * The implementations for computing one layer of a neuronal network. They all give
+ * exactly the same signals (see NeuronalNetwork::set_kernel).
+ */
+enum nn_kernel {NN_KERNEL_SCALAR, NN_KERNEL_SSE2, NN_KERNEL_AVX2, NN_KERNEL_AVX512};
+
+/**
+ * The number formats neuronal networks can be computed with (see
+ * NeuronalNetwork::set_precision). NN_PRECISION_INT8 uses fixed point numbers with
+ * NN_INT8_ONE as 1.0 and integer sums.
+ */
+enum nn_precision {NN_PRECISION_DOUBLE, NN_PRECISION_FLOAT, NN_PRECISION_INT8};
+
+class Genome;
+
+/** Signature of the networks with a topology fixed at compile time. */
+typedef void (*fixed_network_function)(const double* weightings, const double* thresholds,
+                                       const double* signals, const unsigned int quantity,
+                                       bool* decisions);
+
+/**
+ * What an agent remembers of the last computation of its neuronal network, for
+ * NeuronalNetwork::decide_incrementally.
+ */
+struct nn_state {
+	/** Serial number of the network this state belongs to, zero for none. */
+	unsigned long network_serial = 0;
+	/** Incremental computations until the next complete one. */
+	unsigned int updates_left = 0;
+	/** The last input signals. */
+	double signals[NN_MAX_SIGNALS];
+	/** The sums of the weighted input signals of the first layer. */
+	double signal_sums[NN_MAX_SIGNALS];
+	/** The outputs of the first layer, one bit per signal. */
+	unsigned int outputs = 0;
+	/** The last decision. */
+	bool decision = false;
+};
+
+class NeuronalNetwork;
+typedef std::shared_ptr<const NeuronalNetwork> neuronal_network_ptr;
+
+/**
+ * The neuronal network of Agent::neuronal_network with all weightings and thresholds
+ * read from a genome once. Every hidden layer has the same quantity of outputs (the
+ * hidden width, by default as many as the network has inputs), the last layer has a
+ * single output. The weightings are already scaled to -1..1.
+ *
+ * A NeuronalNetwork never changes after it is made, so it can be used by several threads
+ * at once. It is made by Genome::get_neuronal_network and shared by all agents of the
+ * genome (and its copies in other worlds) until the genes change. The weightings for a
+ * reduced precision are made together with the network. The decision cache belongs to
+ * the thread, not to the network.
+ *
+ * The layers are computed by a kernel which is chosen once for all networks, at start
+ * the fastest one of the processor. The networks of Fly and Wasp are computed by code
+ * made for their sizes instead, with any kernel, unless that is switched off (see
+ * NeuronalNetwork::use_fixed_topologies). Networks can also be computed with reduced
+ * precision (float or 8 bit integers), which is faster but not exact. If it is switched
+ * on, networks of genomes with many offspring are turned into machine code (see
+ * NetworkCode).
+ */
+class NeuronalNetwork {
+public:
+	NeuronalNetwork(Genome& genome, const unsigned int new_first_gene,
+	                const unsigned int new_input_size, const unsigned int new_hidden_layers,
+	                const unsigned int new_hidden_width);
+
+	bool decide(const double* signals) const;
+	void decide_batch(const double* signals, const unsigned int quantity,
+	                  bool* decisions) const;
+	bool decide_incrementally(const double* signals, nn_state& state) const;
+	bool fits(const unsigned int other_first_gene, const unsigned int other_input_size,
+	          const unsigned int other_hidden_layers,
+	          const unsigned int other_hidden_width) const;
+	/** Returns the quantity of genes used for this network. */
+	inline unsigned int get_gene_quantity() const { return gene_quantity; }
+	/** Returns the quantity of stored columns for a layer with output_size outputs. */
+	inline static unsigned int columns(unsigned int output_size) {
+		return (output_size + NN_LANES - 1) / NN_LANES * NN_LANES;
+	}
+
+	static bool kernel_available(const nn_kernel kernel);
+	static bool set_kernel(const nn_kernel kernel);
+	static nn_kernel get_kernel();
+	static nn_kernel best_kernel();
+	static void use_fixed_topologies(const bool use);
+	static void set_precision(const nn_precision new_precision);
+	static nn_precision get_precision();
+	static void set_validation(const bool validate);
+	static unsigned long get_validated_decisions();
+	static unsigned long get_decision_mismatches();
+	static void set_cache_step(const double new_step);
+	static double get_cache_step();
+	static unsigned long get_cache_hits();
+	static unsigned long get_cache_misses();
+	static bool set_jit(const bool use);
+
+private:
+	/** Signature of the layer kernels. */
+	typedef void (*layer_function)(const double* input_signals, const unsigned int input_stride,
+	                               const unsigned int input_size, const unsigned int quantity,
+	                               const double* weightings, const double* thresholds,
+	                               const unsigned int layer_columns, double* output_signals,
+	                               const unsigned int output_stride);
+
+	/**
+	 * One remembered decision of the decision cache.
+	 */
+	struct cache_entry {
+		/** Serial number of the network which made the decision. */
+		unsigned long network_serial = 0;
+		/** Key of the rounded input signals, zero for an empty entry. */
+		unsigned long long key = 0;
+		/** The decision for these input signals. */
+		bool decision = false;
+	};
+
+	unsigned long long cache_key(const double* signals) const;
+	void decide_uncached(const double* signals, const unsigned int quantity,
+	                     bool* decisions) const;
+	void decide_exactly(const double* signals, const unsigned int quantity,
+	                    bool* decisions) const;
+	void validate(const double* signals, const unsigned int quantity,
+	              const bool* decisions) const;
+	void reduce_weightings();
+
+	/** Scales a gene value of range 0..1 to a weighting of range -1..1. */
+	inline static double scale(double val) { return (val - 0.5) * 2.0; }
+	/** Returns the quantity of input signals of the given layer. */
+	inline unsigned int inputs_of(unsigned int layer) const {
+		return layer ? hidden_width : input_size;
+	}
+	/** Returns the quantity of output signals of the given layer. */
+	inline unsigned int outputs_of(unsigned int layer) const {
+		return (layer == hidden_layers) ? 1 : hidden_width;
+	}
+
+	/** Unique number of this network. */
+	unsigned long serial;
+	/** Number of the first gene used for this network. */
+	unsigned int first_gene;
+	/** Quantity of genes used for this network. */
+	unsigned int gene_quantity;
+	/** Quantity of input signals. */
+	unsigned int input_size;
+	/** Quantity of hidden layers. */
+	unsigned int hidden_layers;
+	/** Quantity of output signals of every hidden layer. */
+	unsigned int hidden_width;
+	/** The scaled weightings of all layers. Every layer is a matrix with one row per
+	    input signal and NeuronalNetwork::columns columns (output signals). */
+	std::vector<double> weightings;
+	/** The thresholds of all layers, one per column. */
+	std::vector<double> thresholds;
+	/** The precision this network is computed with, the one chosen when it was made. */
+	nn_precision network_precision;
+	/** The weightings for NN_PRECISION_FLOAT, if that is network_precision. */
+	std::vector<float> float_weightings;
+	/** The thresholds for NN_PRECISION_FLOAT, if that is network_precision. */
+	std::vector<float> float_thresholds;
+	/** The weightings for NN_PRECISION_INT8, if that is network_precision. */
+	std::vector<signed char> int8_weightings;
+	/** The thresholds for NN_PRECISION_INT8, scaled for the sums of products, if that is
+	    network_precision. */
+	std::vector<int> int8_thresholds;
+	/** Code made for the topology of this network, or NULL. */
+	fixed_network_function fixed_topology;
+	/** Machine code for this network, or nothing. */
+	network_code_ptr code;
+
+	/** The kernel computing the layers of all networks. */
+	static layer_function layer_kernel;
+	/** The kind of layer_kernel. */
+	static nn_kernel chosen_kernel;
+	/** True if networks with fixed topology are used. */
+	static bool fixed_topologies_used;
+	/** True if machine code is generated for networks. */
+	static bool jit_used;
+	/** The precision of all networks. */
+	static nn_precision precision;
+	/** True if reduced precision decisions are compared with full precision. */
+	static bool validating;
+	/** Quantity of decisions compared with full precision. */
+	static std::atomic<unsigned long> validated_decisions;
+	/** Quantity of decisions which differed from full precision. */
+	static std::atomic<unsigned long> decision_mismatches;
+	/** Serial number of the next network. */
+	static std::atomic<unsigned long> next_serial;
+	/** Step of the decision cache, zero if it is off. */
+	static double cache_step;
+	/** The decision cache of this thread, created at its first use. */
+	static thread_local std::unique_ptr<cache_entry[]> thread_cache;
+	/** Quantity of decisions taken from the cache. */
+	static std::atomic<unsigned long> cache_hits;
+	/** Quantity of decisions computed with the cache switched on. */
+	static std::atomic<unsigned long> cache_misses;
+};
+
+#endif // _NEURONAL_NETWORK_H_
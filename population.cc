@@ -0,0 +1,103 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ */
+
+#include <limits>
+#include "population.h"
+#include "agent.h"
+
+const unsigned int Population::DEAD = std::numeric_limits<unsigned int>::max();
+
+/**
+ * Creates an empty population.
+ */
+Population::Population() :
+	generation(0)
+{
+}
+
+/**
+ * Adds the agent to the living agents. Returns its new handle, which is also given to
+ * the agent.
+ */
+agent_handle Population::add(const agent_ptr& new_agent) {
+	BUG_CHECK(!new_agent, "Agent pointer to nowhere.");
+	agent_handle handle;
+	handle.index = records.size();
+	handle.generation = generation;
+	agent_record record;
+	record.agent = new_agent;
+	record.living_index = living_agents.size();
+	records.push_back(std::move(record));
+	living_agents.push_back(new_agent);
+	living_records.push_back(handle.index);
+	new_agent->set_handle(handle);
+	return handle;
+}
+
+/**
+ * Removes the given agent from the living agents. The last living agent takes its place.
+ * The record of the agent stays until Population::clear.
+ */
+void Population::remove(const agent_handle agent) {
+	BUG_CHECK(!is_living(agent), "Removing agent " << agent.index << " which is not living.");
+	unsigned int hole = records[agent.index].living_index;
+	living_agents[hole] = std::move(living_agents.back());
+	living_records[hole] = living_records.back();
+	records[living_records[hole]].living_index = hole;
+	living_agents.pop_back();
+	living_records.pop_back();
+	records[agent.index].living_index = DEAD;
+}
+
+/**
+ * Removes all living agents. Their records stay until Population::clear.
+ */
+void Population::remove_living() {
+	for (auto const record_index: living_records)
+		records[record_index].living_index = DEAD;
+	living_agents.clear();
+	living_records.clear();
+}
+
+/**
+ * Forgets all agents, living and dead. All handles given until now become invalid.
+ */
+void Population::clear() {
+	records.clear();
+	living_agents.clear();
+	living_records.clear();
+	++generation;
+}
+
+/**
+ * Returns true if the given handle belongs to an agent of this population, living or
+ * dead.
+ */
+bool Population::holds(const agent_handle agent) const {
+	return agent.generation == generation && agent.index < records.size();
+}
+
+/**
+ * Returns true if the agent with the given handle is one of the living agents.
+ */
+bool Population::is_living(const agent_handle agent) const {
+	return holds(agent) && records[agent.index].living_index != DEAD;
+}
+
+/**
+ * Returns the quantity of living agents.
+ */
+unsigned int Population::size() const {
+	return living_agents.size();
+}
+
+/**
+ * Returns true if there are no living agents.
+ */
+bool Population::empty() const {
+	return living_agents.empty();
+}
@@ -0,0 +1,103 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * This file contains the class Population, the agent store of a World.
+ *
+ */
+
+#ifndef _POPULATION_H_
+#define _POPULATION_H_
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "debug_macros.h"
+
+class Agent;
+typedef std::shared_ptr<Agent> agent_ptr;
+
+/**
+ * A stable reference to one agent in a Population. It stays valid after the agents
+ * death, until the population is cleared.
+ */
+struct agent_handle {
+	/** Number of the agents record in the population. */
+	unsigned int index;
+	/** Generation of the population the record belongs to. */
+	unsigned int generation;
+};
+
+inline bool operator==(const agent_handle& a, const agent_handle& b) {
+	return a.index == b.index && a.generation == b.generation;
+}
+
+inline bool operator!=(const agent_handle& a, const agent_handle& b) {
+	return !(a == b);
+}
+
+/**
+ * All agents of a World. Every added agent gets a record and an agent_handle (which it
+ * also knows itself, see Agent::get_handle). Removing an agent takes it out of the
+ * living agents in O(1), but its record stays: dead agents can still be found via
+ * their handles, for example to give them fitness for the eggs they have laid.
+ * Records are never reused before Population::clear, which starts a new generation
+ * of handles. So old handles can be detected.
+ *
+ * Iterating over a population gives the living agents (not in the order they were
+ * added).
+ */
+class Population {
+public:
+	/** Iterator over the living agents. */
+	typedef std::vector<agent_ptr>::const_iterator const_iterator;
+
+	Population();
+
+	agent_handle add(const agent_ptr& new_agent);
+	void remove(const agent_handle agent);
+	void remove_living();
+	void clear();
+	bool holds(const agent_handle agent) const;
+	bool is_living(const agent_handle agent) const;
+	unsigned int size() const;
+	bool empty() const;
+
+	/** Returns the agent with the given handle, living or dead. */
+	inline const agent_ptr& get(const agent_handle agent) const {
+		BUG_CHECK(!holds(agent), "Agent handle " << agent.index << "/" << agent.generation <<
+		          " is not valid in population generation " << generation << ".");
+		return records[agent.index].agent;
+	}
+	/** Returns the first living agent. */
+	inline const_iterator begin() const { return living_agents.begin(); }
+	/** Returns the iterator behind the last living agent. */
+	inline const_iterator end() const { return living_agents.end(); }
+
+private:
+	/**
+	 * Everything the population knows about one agent.
+	 */
+	struct agent_record {
+		/** The agent. */
+		agent_ptr agent;
+		/** Position of the agent in living_agents, or DEAD if it was removed. */
+		unsigned int living_index;
+	};
+	/** living_index of removed agents. */
+	static const unsigned int DEAD;
+
+	/** Records of all agents added since the last Population::clear. Indices are the
+	    handles. */
+	std::vector<agent_record> records;
+	/** The living agents, densely packed. */
+	std::vector<agent_ptr> living_agents;
+	/** Record index of every agent in living_agents. */
+	std::vector<unsigned int> living_records;
+	/** Generation of the handles, incremented with every Population::clear. */
+	unsigned int generation;
+};
+
+#endif // _POPULATION_H_
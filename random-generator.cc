@@ -0,0 +1,64 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ */
+
+#include "random-generator.h"
+
+/** Rotates x left by k bits. */
+static inline uint64_t rotate_left(const uint64_t x, const int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Creates a generator with the given seed.
+ */
+RandomGenerator::RandomGenerator(const uint64_t new_seed) {
+	seed(new_seed);
+}
+
+/**
+ * Starts all lanes again from the given seed. The states are filled with the outputs of
+ * SplitMix64, which are never all zero for one lane. A mirrored generator gives the
+ * complements of the numbers of an unmirrored one with the same seed.
+ */
+void RandomGenerator::seed(const uint64_t new_seed, const bool new_mirrored) {
+	uint64_t splitmix = new_seed;
+	for (unsigned lane=0; lane<RNG_LANES; ++lane)
+		for (unsigned word=0; word<4; ++word) {
+			uint64_t z = (splitmix += 0x9e3779b97f4a7c15ull);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			state[word][lane] = z ^ (z >> 31);
+		}
+	next = RNG_BUFFER_SIZE;
+	mirror = new_mirrored ? ~0ull : 0;
+}
+
+/**
+ * Fills the buffer with new random numbers. Every step computes one number per lane;
+ * the lanes are stored one after another, so the buffer is read step by step.
+ */
+void RandomGenerator::refill() {
+	uint64_t* s0 = state[0];
+	uint64_t* s1 = state[1];
+	uint64_t* s2 = state[2];
+	uint64_t* s3 = state[3];
+	for (unsigned step=0; step<RNG_BUFFER_SIZE; step+=RNG_LANES) {
+#pragma GCC ivdep
+		for (unsigned lane=0; lane<RNG_LANES; ++lane) {
+			uint64_t result = rotate_left(s0[lane] + s3[lane], 23) + s0[lane];
+			values[step + lane] = result ^ mirror;
+			uint64_t t = s1[lane] << 17;
+			s2[lane] ^= s0[lane];
+			s3[lane] ^= s1[lane];
+			s1[lane] ^= s2[lane];
+			s0[lane] ^= s3[lane];
+			s2[lane] ^= t;
+			s3[lane] = rotate_left(s3[lane], 45);
+		}
+	}
+	next = 0;
+}
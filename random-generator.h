@@ -0,0 +1,95 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * This file contains the class RandomGenerator, the random numbers of one World.
+ *
+ */
+
+#ifndef _RANDOM_GENERATOR_H_
+#define _RANDOM_GENERATOR_H_
+
+#include <cstdint>
+#include "debug_macros.h"
+
+/** Quantity of independent xoshiro256++ streams a RandomGenerator computes side by
+    side. The refill loop is vectorized over them. */
+#define RNG_LANES 8
+
+/** Quantity of random numbers a RandomGenerator makes at once. Must be a multiple of
+    RNG_LANES. */
+#define RNG_BUFFER_SIZE 512
+
+/** Seed of all worlds if nothing else is set (see World::set_random_seed). */
+#define RNG_DEFAULT_SEED 1
+
+/**
+ * A fast generator of random numbers. It runs RNG_LANES xoshiro256++ generators
+ * (Blackman and Vigna) in parallel and fills a buffer of RNG_BUFFER_SIZE 64 bit numbers
+ * at once, in a loop the compiler turns into SIMD instructions. The numbers are taken
+ * from the buffer one by one, as doubles of range 0..1 or as integers below a bound.
+ *
+ * xoshiro256++ passes the BigCrush suite of TestU01 and PractRand without failures, on
+ * all of its bits. The lanes are seeded with SplitMix64 from one seed, like its authors
+ * recommend, so they are independent streams for any practical purpose. The test
+ * tests/random-quality.cc checks the statistics of the generator built from them.
+ *
+ * A mirrored generator returns the bitwise complement of every number, so its doubles
+ * are 1-u (minus 2^-53) and its integers count down from the bound. Two generators with
+ * the same seed, one of them mirrored, give antithetic random numbers.
+ *
+ * Every World owns its generators, a generator must only be used by one thread at a
+ * time.
+ */
+class RandomGenerator {
+public:
+	RandomGenerator(const uint64_t new_seed = RNG_DEFAULT_SEED);
+
+	void seed(const uint64_t new_seed, const bool new_mirrored = false);
+
+	/** Returns a random value of range 0..1 (without 1), with 53 random bits. */
+	inline double uniform() {
+		return (next_value() >> 11) * 0x1.0p-53;
+	}
+
+	/**
+	 * Returns a random integer of range 0..bound-1, every one with the same chance. It
+	 * multiplies the upper 32 bits of a random number with the bound and rejects the few
+	 * products which would make it biased (Lemire's method), so mostly no division is
+	 * needed.
+	 */
+	inline unsigned int below(const uint32_t bound) {
+		BUG_CHECK(!bound, "No random integer below zero.");
+		uint64_t product = (next_value() >> 32) * bound;
+		uint32_t low = product;
+		if (low < bound) {
+			uint32_t limit = -bound % bound;
+			while (low < limit) {
+				product = (next_value() >> 32) * bound;
+				low = product;
+			}
+		}
+		return product >> 32;
+	}
+
+private:
+	/** Returns the next random number of the buffer. */
+	inline uint64_t next_value() {
+		if (next == RNG_BUFFER_SIZE)
+			refill();
+		return values[next++];
+	}
+	void refill();
+
+	/** The states of the generators, state[i][lane] is word i of a lane. */
+	alignas(64) uint64_t state[4][RNG_LANES];
+	/** The buffer of random numbers. */
+	alignas(64) uint64_t values[RNG_BUFFER_SIZE];
+	/** Position of the next unused random number in values. */
+	unsigned int next;
+	/** All bits set if the generator is mirrored, otherwise zero. */
+	uint64_t mirror;
+};
+
+#endif // _RANDOM_GENERATOR_H_
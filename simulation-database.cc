@@ -16,6 +16,7 @@
 void SimulationDatabase::clear() {
 	data_set_container::iterator data_set_i = db.begin();
 	while (data_set_i != db.end()) {
+		std::lock_guard<std::mutex> lock((*data_set_i)->mutex);
 		(*data_set_i)->genomes.clear();
 		(*data_set_i)->highest_value = 1.0;
 		(*data_set_i)->max_genome_size = 0;
@@ -53,6 +54,7 @@ void SimulationDatabase::write_db(Glib::RefPtr<Gio::OutputStream> write_stream)
 	// Data
 	data_set_container::iterator data_set_i = db.begin();
 	while (data_set_i != db.end()) {
+		std::lock_guard<std::mutex> lock((*data_set_i)->mutex);
 		genome_data_container::iterator gen_data_i = (*data_set_i)->genomes.begin();
 		unsigned int generation_no = 1;
 		while (gen_data_i != (*data_set_i)->genomes.end()) {
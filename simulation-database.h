@@ -8,6 +8,7 @@
 #ifndef _SIMULATION_DATABASE_H_
 #define _SIMULATION_DATABASE_H_
 
+#include <mutex>
 #include <vector>
 #include <giomm.h>
 #include "genome.h"
@@ -26,6 +27,9 @@ struct data_set {
 	double highest_value;
 	unsigned int max_genome_size;
 	std::vector<string_ptr> gene_names;
+	/** Guards genomes, highest_value and max_genome_size. The statistics pipeline adds
+	    to them in its own thread while the GUI draws them. */
+	std::mutex mutex;
 };
 
 typedef std::shared_ptr<data_set> data_set_ptr;
@@ -37,13 +41,13 @@ typedef std::shared_ptr<SimulationDatabase> simulation_database_ptr;
 
 /**
  * This class contains all logged data of one simulation run.
- * It logs one generation via the method collect and writes all data to a file
- * stream using write_db.
+ * It logs one generation via the method collect, from a snapshot of the world (see
+ * World::make_snapshot), and writes all data to a file stream using write_db.
  */
 class SimulationDatabase {
 
 public:
-	virtual void collect(world_ptr my_world) = 0;
+	virtual void collect(world_snapshot_ptr snapshot) = 0;
 	void print();
 	void write_db(Glib::RefPtr<Gio::OutputStream> write_stream);
 	void clear();
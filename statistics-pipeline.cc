@@ -0,0 +1,98 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ */
+
+#include "statistics-pipeline.h"
+
+/**
+ * Starts the thread which collects into the given database. The given function is
+ * called after every collected snapshot, e.g. to repaint the statistics windows; it runs
+ * in the thread of the pipeline.
+ */
+StatisticsPipeline::StatisticsPipeline(simulation_database_ptr new_database,
+                                       std::function<void()> new_collected_signal,
+                                       const unsigned int new_capacity) :
+	database(new_database),
+	collected_signal(new_collected_signal),
+	capacity(new_capacity),
+	collecting(false),
+	stopping(false),
+	stalls(0)
+{
+	BUG_CHECK(!database, "Statistics pipeline without database.");
+	BUG_CHECK(!capacity, "Statistics pipeline without place for snapshots.");
+	thread = std::thread(&StatisticsPipeline::run, this);
+}
+
+/**
+ * Collects the waiting snapshots and stops the thread.
+ */
+StatisticsPipeline::~StatisticsPipeline() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	changed.notify_all();
+	thread.join();
+}
+
+/**
+ * Gives a snapshot to the pipeline. If there are too many waiting snapshots already, this
+ * waits until one is collected.
+ */
+void StatisticsPipeline::push(world_snapshot_ptr snapshot) {
+	BUG_CHECK(!snapshot, "No snapshot.");
+	std::unique_lock<std::mutex> lock(mutex);
+	if (snapshots.size() >= capacity) {
+		++stalls;
+		changed.wait(lock, [this] { return snapshots.size() < capacity; });
+	}
+	snapshots.push_back(snapshot);
+	lock.unlock();
+	changed.notify_all();
+}
+
+/**
+ * Waits until all given snapshots are collected. Afterwards the database can be used by
+ * this thread, as long as no new snapshot is pushed.
+ */
+void StatisticsPipeline::flush() {
+	std::unique_lock<std::mutex> lock(mutex);
+	changed.wait(lock, [this] { return snapshots.empty() && !collecting; });
+}
+
+/**
+ * Returns how many times the simulation had to wait because the statistics fell behind.
+ */
+unsigned long StatisticsPipeline::get_stalls() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return stalls;
+}
+
+/**
+ * The loop of the pipeline thread.
+ */
+void StatisticsPipeline::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		changed.wait(lock, [this] { return !snapshots.empty() || stopping; });
+		if (snapshots.empty())
+			return;
+		world_snapshot_ptr snapshot = snapshots.front();
+		snapshots.pop_front();
+		collecting = true;
+		lock.unlock();
+		changed.notify_all();
+
+		database->collect(snapshot);
+		if (collected_signal)
+			collected_signal();
+
+		lock.lock();
+		collecting = false;
+		changed.notify_all();
+	}
+}
@@ -0,0 +1,74 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * This file contains the class StatisticsPipeline, which collects the statistics of a
+ * simulation in its own thread.
+ *
+ */
+
+#ifndef _STATISTICS_PIPELINE_H_
+#define _STATISTICS_PIPELINE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "simulation-database.h"
+#include "world.h"
+#include "debug_macros.h"
+
+/** Quantity of snapshots which may wait for their collection. */
+#define STATISTICS_QUEUE_SIZE 4
+
+class StatisticsPipeline;
+typedef std::shared_ptr<StatisticsPipeline> statistics_pipeline_ptr;
+
+/**
+ * Puts world snapshots into a SimulationDatabase in its own thread, so the simulation can
+ * go on with the next generation meanwhile. The snapshots are collected in the order they
+ * are given. If the collection falls behind by STATISTICS_QUEUE_SIZE snapshots, the
+ * simulation waits.
+ */
+class StatisticsPipeline {
+public:
+	StatisticsPipeline(simulation_database_ptr new_database,
+	                   std::function<void()> new_collected_signal = std::function<void()>(),
+	                   const unsigned int new_capacity = STATISTICS_QUEUE_SIZE);
+	~StatisticsPipeline();
+	StatisticsPipeline(const StatisticsPipeline&) = delete;
+	StatisticsPipeline& operator=(const StatisticsPipeline&) = delete;
+
+	void push(world_snapshot_ptr snapshot);
+	void flush();
+	unsigned long get_stalls() const;
+
+private:
+	void run();
+
+	/** The database the snapshots are collected into. */
+	simulation_database_ptr database;
+	/** Called in the pipeline thread after every collected snapshot. */
+	std::function<void()> collected_signal;
+	/** Quantity of snapshots which may wait. */
+	unsigned int capacity;
+	/** The snapshots which wait for their collection, the oldest at the front. */
+	std::deque<world_snapshot_ptr> snapshots;
+	/** True while a snapshot is collected. */
+	bool collecting;
+	/** True when the pipeline is destroyed. */
+	bool stopping;
+	/** How many times push had to wait for a free place. */
+	unsigned long stalls;
+	/** Guards all members above. */
+	mutable std::mutex mutex;
+	/** Signals new snapshots, free places and finished collections. */
+	std::condition_variable changed;
+	/** The thread which collects. */
+	std::thread thread;
+};
+
+#endif // _STATISTICS_PIPELINE_H_
@@ -0,0 +1,290 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ */
+
+#include <chrono>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "task-pool.h"
+
+typedef std::chrono::steady_clock pool_clock;
+
+/** Returns the nanoseconds since the given point in time. */
+static long long nanoseconds_since(const pool_clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(pool_clock::now() - start)
+		.count();
+}
+
+/**
+ * Starts the given quantity of threads. Zero means one thread per processor core.
+ */
+TaskPool::TaskPool(const unsigned int new_thread_quantity) :
+	queued(0),
+	stopping(false)
+{
+	unsigned int thread_quantity = new_thread_quantity ? new_thread_quantity :
+		std::thread::hardware_concurrency();
+	if (!thread_quantity)
+		thread_quantity = 1;
+
+	for (unsigned number=0; number<thread_quantity; ++number) {
+		workers.emplace_back(new worker);
+		workers.back()->pool = this;
+		workers.back()->number = number;
+		workers.back()->depth = 0;
+	}
+	reset_metrics();
+	for (auto const& thread_worker: workers)
+		thread_worker->thread = std::thread(&TaskPool::work, this, thread_worker.get());
+}
+
+/**
+ * Runs the queued tasks and stops all threads.
+ */
+TaskPool::~TaskPool() {
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto const& thread_worker: workers)
+		thread_worker->thread.join();
+}
+
+/**
+ * Returns the pool all worlds use. It is created with the first call.
+ */
+TaskPool& TaskPool::instance() {
+	static TaskPool pool(instance_thread_quantity);
+	return pool;
+}
+
+/**
+ * Sets the quantity of threads of TaskPool::instance. Zero (the default) means one per
+ * processor core. This must be called before the pool is used for the first time.
+ */
+void TaskPool::set_instance_thread_quantity(const unsigned int new_thread_quantity) {
+	instance_thread_quantity = new_thread_quantity;
+}
+
+/**
+ * Returns the quantity of threads of this pool.
+ */
+unsigned int TaskPool::get_thread_quantity() const {
+	return workers.size();
+}
+
+/**
+ * Pins every thread to one processor core (thread n to core n, starting again after the
+ * last core), or lets all threads run on all cores again. Pinned threads keep their
+ * caches, but a core which is busy with another program slows its thread down.
+ * Only Linux supports it, elsewhere this does nothing.
+ */
+void TaskPool::set_affinity(const bool pinned) {
+#ifdef __linux__
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (!cores)
+		return;
+	for (auto const& thread_worker: workers) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		if (pinned)
+			CPU_SET(thread_worker->number % cores, &cpus);
+		else
+			for (unsigned core=0; core<cores; ++core)
+				CPU_SET(core, &cpus);
+		pthread_setaffinity_np(thread_worker->thread.native_handle(), sizeof(cpus), &cpus);
+	}
+#endif
+}
+
+/**
+ * Returns the metrics of all threads, in the order of their numbers.
+ */
+std::vector<worker_metrics> TaskPool::get_metrics() const {
+	std::vector<worker_metrics> metrics;
+	for (auto const& thread_worker: workers) {
+		worker_metrics thread_metrics;
+		thread_metrics.tasks = thread_worker->tasks_run;
+		thread_metrics.steals = thread_worker->steals;
+		thread_metrics.busy_time = thread_worker->busy_time * 1e-9;
+		thread_metrics.idle_time = thread_worker->idle_time * 1e-9;
+		metrics.push_back(thread_metrics);
+	}
+	return metrics;
+}
+
+/**
+ * Sets the metrics of all threads to zero.
+ */
+void TaskPool::reset_metrics() {
+	for (auto const& thread_worker: workers) {
+		thread_worker->tasks_run = 0;
+		thread_worker->steals = 0;
+		thread_worker->busy_time = 0;
+		thread_worker->idle_time = 0;
+	}
+}
+
+/**
+ * Queues a task. In a thread of this pool it is put into the queue of the thread,
+ * otherwise into the shared queue.
+ */
+void TaskPool::submit(queued_task&& new_task) {
+	worker* self = current_worker;
+	++queued;
+	if (self && self->pool == this) {
+		std::lock_guard<std::mutex> lock(self->mutex);
+		self->tasks.push_back(std::move(new_task));
+	} else {
+		std::lock_guard<std::mutex> lock(shared_mutex);
+		shared_tasks.push_back(std::move(new_task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+	}
+	wake.notify_one();
+}
+
+/**
+ * Takes the next task for the given worker (NULL for a thread outside of the pool): the
+ * newest one of its own queue, the oldest shared one, or the oldest one of another
+ * thread. Returns false if all queues are empty.
+ */
+bool TaskPool::take(worker* self, queued_task& next_task, bool& stolen) {
+	stolen = false;
+	if (self) {
+		std::lock_guard<std::mutex> lock(self->mutex);
+		if (!self->tasks.empty()) {
+			next_task = std::move(self->tasks.back());
+			self->tasks.pop_back();
+			return true;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(shared_mutex);
+		if (!shared_tasks.empty()) {
+			next_task = std::move(shared_tasks.front());
+			shared_tasks.pop_front();
+			return true;
+		}
+	}
+	unsigned int first = self ? self->number + 1 : 0;
+	for (unsigned i=0; i<workers.size(); ++i) {
+		worker* victim = workers[(first + i) % workers.size()].get();
+		if (victim == self)
+			continue;
+		std::lock_guard<std::mutex> lock(victim->mutex);
+		if (!victim->tasks.empty()) {
+			next_task = std::move(victim->tasks.front());
+			victim->tasks.pop_front();
+			stolen = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Runs one task if there is one. Returns false if all queues are empty.
+ */
+bool TaskPool::run_one(worker* self) {
+	queued_task next_task;
+	bool stolen;
+	if (!take(self, next_task, stolen))
+		return false;
+	--queued;
+
+	pool_clock::time_point start = pool_clock::now();
+	if (self)
+		++self->depth;
+	next_task.function();
+	if (self) {
+		// Nested tasks are part of the time of the outermost one.
+		if (!--self->depth)
+			self->busy_time += nanoseconds_since(start);
+		++self->tasks_run;
+		if (stolen)
+			++self->steals;
+	}
+
+	// The waiting thread may destroy the group as soon as nothing is pending.
+	if (!--next_task.group->pending) {
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+		}
+		wake.notify_all();
+	}
+	return true;
+}
+
+/**
+ * Runs tasks until all tasks of the given group are finished.
+ */
+void TaskPool::wait_for(TaskGroup& group) {
+	worker* self = current_worker && current_worker->pool == this ? current_worker : NULL;
+	while (group.pending) {
+		if (run_one(self))
+			continue;
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		wake.wait(lock, [&] { return queued || !group.pending; });
+	}
+}
+
+/**
+ * The loop of every thread of the pool.
+ */
+void TaskPool::work(worker* self) {
+	current_worker = self;
+	for (;;) {
+		if (run_one(self))
+			continue;
+		pool_clock::time_point start = pool_clock::now();
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		wake.wait(lock, [this] { return queued || stopping; });
+		if (stopping && !queued)
+			return;
+		lock.unlock();
+		self->idle_time += nanoseconds_since(start);
+	}
+}
+
+thread_local TaskPool::worker* TaskPool::current_worker = NULL;
+unsigned int TaskPool::instance_thread_quantity = 0;
+
+/**
+ * Creates an empty group for the given pool.
+ */
+TaskGroup::TaskGroup(TaskPool& new_pool) :
+	pool(new_pool),
+	pending(0)
+{
+}
+
+/**
+ * Waits for all tasks of the group.
+ */
+TaskGroup::~TaskGroup() {
+	wait();
+}
+
+/**
+ * Queues a task of this group.
+ */
+void TaskGroup::run(std::function<void()> function) {
+	++pending;
+	pool.submit({std::move(function), this});
+}
+
+/**
+ * Returns when all tasks of the group are finished. Meanwhile this thread runs tasks of
+ * the pool, too.
+ */
+void TaskGroup::wait() {
+	pool.wait_for(*this);
+}
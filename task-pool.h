@@ -0,0 +1,153 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * This file contains the classes TaskPool, threads which run tasks, and TaskGroup, tasks
+ * which are waited for together.
+ *
+ */
+
+#ifndef _TASK_POOL_H_
+#define _TASK_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "debug_macros.h"
+
+class TaskGroup;
+
+/**
+ * What one thread of a TaskPool has done since the pool was created or since the last
+ * call of TaskPool::reset_metrics.
+ */
+struct worker_metrics {
+	/** Quantity of tasks the thread has run. */
+	unsigned long tasks;
+	/** Quantity of these tasks which were taken from other threads. */
+	unsigned long steals;
+	/** Seconds spent in tasks, including the waits for the tasks they created. */
+	double busy_time;
+	/** Seconds spent waiting for tasks. */
+	double idle_time;
+
+	/** Returns the share of the time the thread was busy, 0..1. */
+	double utilization() const {
+		double time = busy_time + idle_time;
+		return time > 0.0 ? busy_time / time : 0.0;
+	}
+};
+
+/**
+ * A fixed quantity of threads which run the tasks of TaskGroups. Every thread has its
+ * own queue. The tasks a thread creates are put into its own queue and run last in,
+ * first out, so nested tasks are computed where their data was made. A thread without
+ * tasks steals the oldest task from the queue of another thread, which is mostly the
+ * biggest one. Tasks from threads outside of the pool are shared by all threads.
+ *
+ * A thread which waits for a TaskGroup runs other tasks meanwhile, so tasks can create
+ * and wait for groups of tasks themselves, in any depth. Tasks must not wait for
+ * anything else which is computed by other tasks.
+ */
+class TaskPool {
+public:
+	TaskPool(const unsigned int new_thread_quantity = 0);
+	~TaskPool();
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+
+	static TaskPool& instance();
+	static void set_instance_thread_quantity(const unsigned int new_thread_quantity);
+
+	unsigned int get_thread_quantity() const;
+	void set_affinity(const bool pinned);
+	std::vector<worker_metrics> get_metrics() const;
+	void reset_metrics();
+
+private:
+	friend class TaskGroup;
+
+	/** A task and the group which waits for it. */
+	struct queued_task {
+		std::function<void()> function;
+		TaskGroup* group;
+	};
+
+	/** One thread of the pool. */
+	struct worker {
+		/** The pool of the thread. */
+		TaskPool* pool;
+		/** Number of the thread in the pool. */
+		unsigned int number;
+		/** Quantity of tasks the thread is running, nested ones included. */
+		unsigned int depth;
+		/** Guards tasks. */
+		std::mutex mutex;
+		/** The tasks of this thread, the newest at the back. */
+		std::deque<queued_task> tasks;
+		/** The thread. */
+		std::thread thread;
+		/** See worker_metrics. The times are in nanoseconds. */
+		std::atomic<unsigned long> tasks_run;
+		std::atomic<unsigned long> steals;
+		std::atomic<long long> busy_time;
+		std::atomic<long long> idle_time;
+	};
+
+	void submit(queued_task&& new_task);
+	bool take(worker* self, queued_task& next_task, bool& stolen);
+	bool run_one(worker* self);
+	void wait_for(TaskGroup& group);
+	void work(worker* self);
+
+	/** The threads of the pool. */
+	std::vector<std::unique_ptr<worker>> workers;
+	/** Guards shared_tasks. */
+	std::mutex shared_mutex;
+	/** Tasks from threads outside of the pool. */
+	std::deque<queued_task> shared_tasks;
+	/** Quantity of tasks in all queues. */
+	std::atomic<unsigned long> queued;
+	/** Guards stopping and the waits on wake. */
+	std::mutex sleep_mutex;
+	/** Wakes threads when tasks are queued or a group is finished. */
+	std::condition_variable wake;
+	/** True when the pool is destroyed. */
+	bool stopping;
+
+	/** The worker this thread is, NULL outside of all pools. */
+	static thread_local worker* current_worker;
+	/** Quantity of threads of TaskPool::instance. */
+	static unsigned int instance_thread_quantity;
+};
+
+/**
+ * Tasks which are run by a TaskPool and waited for together. The destructor waits for
+ * all tasks of the group.
+ */
+class TaskGroup {
+public:
+	TaskGroup(TaskPool& new_pool = TaskPool::instance());
+	~TaskGroup();
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	void run(std::function<void()> function);
+	void wait();
+
+private:
+	friend class TaskPool;
+
+	/** The pool which runs the tasks. */
+	TaskPool& pool;
+	/** Quantity of tasks which are not finished yet. */
+	std::atomic<unsigned long> pending;
+};
+
+#endif // _TASK_POOL_H_
@@ -0,0 +1,128 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * Test that agents do not allocate memory while they cognite. Run it with "make check".
+ *
+ * operator new is replaced by a counting one. A Bushworld of the default
+ * Bushworldhandler scenario computes one generation, so the genomes get their genes,
+ * and then a part of the next one. All living agents cognite once, which compiles the
+ * neuronal networks of their genomes, and then several times more with different
+ * perceptions while the allocations are counted. The same is done for batches of all
+ * agents of one type (see Agent::cognite_batch), after one batch has filled the scratch
+ * memory. There must be no allocations.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "agent.h"
+#include "bushworldhandler.h"
+#include "bushworld.h"
+
+/** True while allocations are counted in this thread. */
+static thread_local bool counting = false;
+/** Quantity of counted allocations. */
+static std::atomic<unsigned long> allocations(0);
+
+void* operator new(std::size_t size) {
+	if (counting)
+		++allocations;
+	void* memory = std::malloc(size ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+/**
+ * Returns the perception number n of a series which makes the agents lay eggs, stay
+ * on their branch and leave it.
+ */
+static perception make_perception(const unsigned int n, const turn_counter time) {
+	perception pcpt = perception();
+	pcpt.fruits_in_branch = 50;
+	pcpt.fruit_free = !(n % 5);
+	pcpt.fly_eggs_in_fruit = n % 3;
+	pcpt.wasp_eggs_in_fruit = pcpt.fly_eggs_in_fruit ? 1 - n % 2 : 0;
+	pcpt.foreign_eggs_in_fruit = n % 4;
+	pcpt.current_time = time + n * 0.1;
+	return pcpt;
+}
+
+int main() {
+	const unsigned int rounds = 20;
+	Bushworldhandler handler;
+	world_ptr world = handler.get_world();
+	handler.run_one_generation();
+
+	World::random_scope randomness(*world);
+	world->clear_population();
+	world->create_offspring();
+	world->reset_statistics();
+	world->set_time(0.0);
+	for (unsigned run=0; run<2000 && world->run(); ++run);
+
+	std::vector<agent_ptr> agents(world->get_population()->begin(),
+	                              world->get_population()->end());
+	// With perception 3 all agents think with their neuronal networks.
+	for (unsigned i=0; i<agents.size(); ++i) {
+		perception pcpt = make_perception(3, 1000.0);
+		agents[i]->cognite(&pcpt);
+	}
+
+	counting = true;
+	for (unsigned round=0; round<rounds; ++round)
+		for (unsigned i=0; i<agents.size(); ++i) {
+			perception pcpt = make_perception(i + round, 1000.0 + round);
+			agents[i]->cognite(&pcpt);
+		}
+	counting = false;
+
+	unsigned long cognitions = rounds * agents.size();
+	printf("%lu allocations in %lu cognitions.\n", (unsigned long)allocations, cognitions);
+	bool failed = allocations > 0;
+
+	// The agents sorted by type, and their perceptions and actions.
+	std::stable_sort(agents.begin(), agents.end(), [](const agent_ptr& a, const agent_ptr& b) {
+		return typeid(*a).before(typeid(*b));
+	});
+	std::vector<perception> perceptions(agents.size());
+	std::vector<action> actions(agents.size());
+	cognition_batch scratch;
+	unsigned long batches = 0;
+	allocations = 0;
+	for (unsigned round=0; round<=rounds; ++round) {
+		for (unsigned i=0; i<agents.size(); ++i)
+			perceptions[i] = make_perception(round ? i + round : 3, 2000.0 + round);
+		counting = round > 0;
+		unsigned int first = 0;
+		while (first < agents.size()) {
+			unsigned int end = first + 1;
+			while (end < agents.size() && typeid(*agents[end]) == typeid(*agents[first]))
+				++end;
+			agents[first]->cognite_batch(&agents[first], &perceptions[first], &actions[first],
+			                             end - first, scratch);
+			batches += counting;
+			first = end;
+		}
+		counting = false;
+	}
+	printf("%lu allocations in %lu batches of %lu cognitions.\n", (unsigned long)allocations,
+	       batches, cognitions);
+	failed |= allocations > 0;
+	world->kill_all_agents();
+	printf(failed ? "FAILED\n" : "OK\n");
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,244 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * LEvoSim
+ * Copyright (C) Lew Palm 2019 <lp@lew-palm.de>
+ *
+ * Statistical test of RandomGenerator. Run it with "make check".
+ *
+ * This is no replacement for TestU01 or PractRand, which xoshiro256++ itself passes. It
+ * checks that the generator built from it is sound: the lanes, the buffer, the
+ * conversion to doubles, RandomGenerator::below and the mirrored generators. Every test
+ * computes a statistic which is normally distributed (or a chi-square, which is
+ * approximated by a normal distribution) and fails if it is more than
+ * RNG_TEST_MAX_DEVIATION standard deviations away from its expected value. The seeds
+ * are fixed, so the results are the same in every run.
+ *
+ * - Mean and variance of uniform().
+ * - Chi-square of uniform() in 1024 buckets, and of pairs of consecutive values in
+ *   32x32 buckets.
+ * - The frequency of each of the upper 32 bits of uniform().
+ * - The correlation of values with the ones 1 to 2*RNG_LANES places later, which covers
+ *   neighbouring lanes and the same lane.
+ * - Chi-square of below() for several bounds, including ones where rejections are
+ *   frequent, and that no value reaches the bound.
+ * - The correlation of generators with neighbouring seeds.
+ * - That a generator seeded again repeats its numbers, and that a mirrored generator
+ *   gives exactly 1-u (minus 2^-53) for every u of an unmirrored one.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "random-generator.h"
+
+/** A test fails if its statistic deviates by more standard deviations than this. */
+#define RNG_TEST_MAX_DEVIATION 5.0
+
+/** Quantity of random numbers of most tests. */
+#define RNG_TEST_SAMPLES 10000000
+
+/** Quantity of failed tests. */
+static unsigned int failures = 0;
+
+/**
+ * Prints the result of a test with the given deviation in standard deviations and counts
+ * it as failed if the deviation is too big.
+ */
+static void report(const char* name, const double deviation) {
+	bool failed = !(std::fabs(deviation) <= RNG_TEST_MAX_DEVIATION);
+	printf("%-40s %10.3f %s\n", name, deviation, failed ? "FAILED" : "ok");
+	failures += failed;
+}
+
+/**
+ * Prints the result of a test which has no statistic.
+ */
+static void report(const char* name, const bool passed) {
+	printf("%-40s %10s %s\n", name, "", passed ? "ok" : "FAILED");
+	failures += !passed;
+}
+
+/**
+ * Returns the deviation of a chi-square statistic of the given bucket counts from its
+ * expected value, in standard deviations. All buckets have the same chance.
+ */
+static double chi_square_deviation(const std::vector<unsigned long>& counts,
+                                   const unsigned long samples) {
+	double expected = (double)samples / counts.size();
+	double chi_square = 0.0;
+	for (auto const& count: counts)
+		chi_square += (count - expected) * (count - expected) / expected;
+	double degrees = counts.size() - 1;
+	return (chi_square - degrees) / std::sqrt(2.0 * degrees);
+}
+
+/**
+ * Tests the mean and the variance of uniform(), which are 1/2 and 1/12.
+ */
+static void test_moments() {
+	RandomGenerator random(1);
+	double sum = 0.0;
+	double square_sum = 0.0;
+	for (unsigned n=0; n<RNG_TEST_SAMPLES; ++n) {
+		double u = random.uniform();
+		sum += u;
+		square_sum += (u - 0.5) * (u - 0.5);
+	}
+	double mean = sum / RNG_TEST_SAMPLES;
+	double variance = square_sum / RNG_TEST_SAMPLES;
+	// The variance of u is 1/12, the one of (u-1/2)^2 is 1/80 - 1/144.
+	report("uniform mean", (mean - 0.5) / std::sqrt(1.0 / 12.0 / RNG_TEST_SAMPLES));
+	report("uniform variance", (variance - 1.0 / 12.0) /
+	       std::sqrt((1.0 / 80.0 - 1.0 / 144.0) / RNG_TEST_SAMPLES));
+}
+
+/**
+ * Tests uniform() and pairs of consecutive values of it with chi-square in buckets.
+ */
+static void test_buckets() {
+	RandomGenerator random(2);
+	std::vector<unsigned long> counts(1024, 0);
+	for (unsigned n=0; n<RNG_TEST_SAMPLES; ++n)
+		++counts[random.uniform() * 1024];
+	report("uniform chi-square, 1024 buckets",
+	       chi_square_deviation(counts, RNG_TEST_SAMPLES));
+
+	std::vector<unsigned long> pair_counts(32 * 32, 0);
+	for (unsigned n=0; n<RNG_TEST_SAMPLES; ++n) {
+		unsigned int first = random.uniform() * 32;
+		unsigned int second = random.uniform() * 32;
+		++pair_counts[first * 32 + second];
+	}
+	report("pairs chi-square, 32x32 buckets",
+	       chi_square_deviation(pair_counts, RNG_TEST_SAMPLES));
+}
+
+/**
+ * Tests that each of the upper 32 bits of uniform() is set in half of the values.
+ */
+static void test_bits() {
+	RandomGenerator random(3);
+	std::vector<unsigned long> ones(32, 0);
+	for (unsigned n=0; n<RNG_TEST_SAMPLES; ++n) {
+		uint32_t bits = random.uniform() * 4294967296.0;
+		for (unsigned bit=0; bit<32; ++bit)
+			ones[bit] += (bits >> bit) & 1;
+	}
+	double worst = 0.0;
+	for (auto const& count: ones) {
+		double deviation = (count - RNG_TEST_SAMPLES / 2.0) /
+			std::sqrt(RNG_TEST_SAMPLES / 4.0);
+		if (std::fabs(deviation) > std::fabs(worst))
+			worst = deviation;
+	}
+	report("bit frequency, worst of 32 bits", worst);
+}
+
+/**
+ * Tests the correlation of every value of uniform() with the values 1 to 2*RNG_LANES
+ * places later. In the buffer, the next value of the same lane is RNG_LANES places
+ * later.
+ */
+static void test_serial_correlation() {
+	RandomGenerator random(4);
+	std::vector<double> values(RNG_TEST_SAMPLES);
+	for (auto& value: values)
+		value = random.uniform() - 0.5;
+	double worst = 0.0;
+	for (unsigned lag=1; lag<=2 * RNG_LANES; ++lag) {
+		double sum = 0.0;
+		for (unsigned n=0; n+lag<RNG_TEST_SAMPLES; ++n)
+			sum += values[n] * values[n + lag];
+		// Every product has the variance 1/144.
+		double deviation = sum / std::sqrt((RNG_TEST_SAMPLES - lag) / 144.0);
+		if (std::fabs(deviation) > std::fabs(worst))
+			worst = deviation;
+	}
+	report("serial correlation, worst of lags", worst);
+}
+
+/**
+ * Tests RandomGenerator::below with chi-square for several bounds. 3 * 2^30 + 1 makes
+ * rejections frequent. Bigger bounds are counted in 1024 buckets, which differ by at
+ * most one value, so their chances are computed exactly.
+ */
+static void test_below() {
+	RandomGenerator random(5);
+	bool in_range = true;
+	for (uint32_t bound: {2u, 3u, 37u, 1000u, 3u * (1u << 30) + 1}) {
+		unsigned int buckets = std::min(bound, 1024u);
+		std::vector<unsigned long> counts(buckets, 0);
+		for (unsigned n=0; n<RNG_TEST_SAMPLES; ++n) {
+			unsigned int value = random.below(bound);
+			in_range = in_range && value < bound;
+			++counts[(uint64_t)value * buckets / bound];
+		}
+		double chi_square = 0.0;
+		for (unsigned bucket=0; bucket<buckets; ++bucket) {
+			uint64_t first = ((uint64_t)bucket * bound + buckets - 1) / buckets;
+			uint64_t end = ((uint64_t)(bucket + 1) * bound + buckets - 1) / buckets;
+			double expected = (double)RNG_TEST_SAMPLES * (end - first) / bound;
+			chi_square += (counts[bucket] - expected) * (counts[bucket] - expected) / expected;
+		}
+		char name[64];
+		snprintf(name, sizeof(name), "below(%u) chi-square", bound);
+		report(name, (chi_square - (buckets - 1)) / std::sqrt(2.0 * (buckets - 1)));
+	}
+	report("below values under the bound", in_range);
+}
+
+/**
+ * Tests the correlation of generators with neighbouring seeds, which are the most
+ * similar ones for the seeding with SplitMix64.
+ */
+static void test_seeds() {
+	double worst = 0.0;
+	for (uint64_t seed=1; seed<=8; ++seed) {
+		RandomGenerator first(seed);
+		RandomGenerator second(seed + 1);
+		double sum = 0.0;
+		for (unsigned n=0; n<RNG_TEST_SAMPLES / 8; ++n)
+			sum += (first.uniform() - 0.5) * (second.uniform() - 0.5);
+		double deviation = sum / std::sqrt(RNG_TEST_SAMPLES / 8 / 144.0);
+		if (std::fabs(deviation) > std::fabs(worst))
+			worst = deviation;
+	}
+	report("neighbouring seeds correlation, worst", worst);
+}
+
+/**
+ * Tests that seeding again repeats the numbers and that mirrored generators give
+ * exactly the complements.
+ */
+static void test_reproduction() {
+	RandomGenerator random(6);
+	std::vector<double> values(3 * RNG_BUFFER_SIZE);
+	for (auto& value: values)
+		value = random.uniform();
+
+	bool repeated = true;
+	random.seed(6);
+	for (auto const& value: values)
+		repeated = repeated && random.uniform() == value;
+	report("seeded again, same numbers", repeated);
+
+	bool mirrored = true;
+	random.seed(6, true);
+	for (auto const& value: values)
+		mirrored = mirrored && random.uniform() == 1.0 - 0x1.0p-53 - value;
+	report("mirrored, complementary numbers", mirrored);
+}
+
+int main() {
+	test_moments();
+	test_buckets();
+	test_bits();
+	test_serial_correlation();
+	test_below();
+	test_seeds();
+	test_reproduction();
+	printf(failures ? "FAILED\n" : "OK\n");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -7,98 +7,159 @@
 
 #include "wasp.h"
 
+/**
+ * Creates a wasp. Its state is stored in an InsectStore, see Wasp::join_store.
+ */
 Wasp::Wasp(genome_ptr mygen) : 
-	Insect(mygen),
-	fly_eggs_seen(0),
-	empty_fruits_seen(0),
-	own_eggs_seen(0),
-	foreign_wasp_eggs_seen(0),
-	laid_eggs(0),
-	cluster_laid_eggs(0),
-	bad_fruits_seen(0)
+	Insect(mygen, true)
 {
 	agent_type = "Wasp";
 }
 
+/**
+ * Puts this wasp into the wasp columns of the given store.
+ */
+void Wasp::join_store(InsectStore* store) {
+	wasp_columns* wasps = store->get_wasps();
+	set_columns(wasps, wasps->add_row());
+}
+
 /**
  * The wasp gets his perception and has to decide, means: has to return an object of
  * type action. The main decision is about leaving or not leaving the branch. This is
  * done by an artificial neuronal network.
  */
 action Wasp::cognite(const perception* pcpt) {
-	cognition_start_statistics(pcpt);
 	action ret;
+
+	if (perceive(pcpt, &ret)) {
+		// The perception vector.
+		double sigs[WASP_NN_INPUTS];
+		fill_input_signals(sigs, pcpt);
+		decide(pcpt, neuronal_network(sigs, WASP_NN_INPUTS), &ret);
+	}
+	return ret;
+}
+
+/**
+ * The same as Wasp::cognite, but for several wasps at once. First all wasps look at
+ * their perceptions, then all neuronal networks are computed together (see
+ * Agent::neuronal_networks), and at last the decisions are turned into actions. The
+ * containers in between are taken from scratch, so nothing is allocated.
+ */
+void Wasp::cognite_batch(const agent_ptr* agents, const perception* pcpts, action* actions,
+                         const unsigned int quantity, cognition_batch& scratch) {
+	scratch.thinker_positions.clear();
+	scratch.thinkers.clear();
+	for (unsigned i=0; i<quantity; ++i) {
+		Wasp* cooper = static_cast<Wasp*>(agents[i].get());
+		if (cooper->perceive(&pcpts[i], &actions[i])) {
+			scratch.thinker_positions.push_back(i);
+			scratch.thinkers.push_back(cooper);
+		}
+	}
+
+	const unsigned int thinkers = scratch.thinkers.size();
+	scratch.signals.resize(thinkers * WASP_NN_INPUTS);
+	for (unsigned t=0; t<thinkers; ++t)
+		static_cast<Wasp*>(scratch.thinkers[t])->fill_input_signals(
+			&scratch.signals[t * WASP_NN_INPUTS], &pcpts[scratch.thinker_positions[t]]);
+	bool* leaving = scratch.get_decisions(thinkers);
+	neuronal_networks(scratch.thinkers.data(), scratch.signals.data(), WASP_NN_INPUTS, thinkers,
+	                  leaving, scratch);
+
+	for (unsigned t=0; t<thinkers; ++t) {
+		unsigned int i = scratch.thinker_positions[t];
+		static_cast<Wasp*>(scratch.thinkers[t])->decide(&pcpts[i], leaving[t], &actions[i]);
+	}
+}
+
+/**
+ * First step of a cognition: the wasp looks at its perception and updates its
+ * statistics. If there is a fly egg without wasp egg, the wasp lays an egg, which is
+ * written to ret. Otherwise this returns true, because the wasp has to think about
+ * leaving the branch.
+ */
+bool Wasp::perceive(const perception* pcpt, action* ret) {
+	cognition_start_statistics(pcpt);
+	wasp_columns& c = cols();
 	
-	ret.intensity = 1.0;
+	ret->intensity = 1.0;
 	if (pcpt->fruit_free) {
-		++empty_fruits_seen;
+		++c.empty_fruits_seen[row];
 	} else {
-		own_eggs_seen += pcpt->own_eggs_in_fruit;
-		foreign_wasp_eggs_seen += pcpt->wasp_eggs_in_fruit - pcpt->own_eggs_in_fruit;
-		fly_eggs_seen += pcpt->fly_eggs_in_fruit;
+		c.own_eggs_seen[row] += pcpt->own_eggs_in_fruit;
+		c.foreign_wasp_eggs_seen[row] += pcpt->wasp_eggs_in_fruit - pcpt->own_eggs_in_fruit;
+		c.fly_eggs_seen[row] += pcpt->fly_eggs_in_fruit;
 	}
 	
 	if ((pcpt->fly_eggs_in_fruit) && (!pcpt->wasp_eggs_in_fruit)) {
-		ret.type = LAY_EGG;
-		++laid_eggs;
-		++cluster_laid_eggs;
-	} else {
-		if (!pcpt->own_eggs_in_fruit)
-			++bad_fruits_seen;
-		// The perception vector.
-		nn_signals_ptr sigs = nn_signals_ptr(new nn_signals());
+		ret->type = LAY_EGG;
+		++c.laid_eggs[row];
+		++c.cluster_laid_eggs[row];
+		return false;
+	}
 
-		// Collected personal statistics as perceptions:
-		sigs->push_back(sigmoid(foreign_wasp_eggs_seen));   // on current branch
-		sigs->push_back(sigmoid(empty_fruits_seen));		// on current branch
-		sigs->push_back(sigmoid(laid_eggs));				// in the whole bush
-		sigs->push_back(sigmoid(cluster_laid_eggs));		// on current branch
-		sigs->push_back(sigmoid(fly_eggs_seen));			// on current branch
-		sigs->push_back(sigmoid(cluster_jumps));			// in the whole bush
-		sigs->push_back(sigmoid(bad_fruits_seen));			// in the whole bush
-		sigs->push_back(sigmoid((pcpt->current_time - birth_time) / (max_age - birth_time))); // Lifetime normalized
+	if (!pcpt->own_eggs_in_fruit)
+		++c.bad_fruits_seen[row];
+	return true;
+}
 
-		// McNamara-Houston-input (reward rates):
-		double average_reward_rate = cluster_jumps ? reward_rate_sum / cluster_jumps : 0.0;
-		sigs->push_back(sigmoid(average_reward_rate)); // Average reward rate.
-		static const double time_scaler = 0.05;
-		double branchtime = (pcpt->current_time - last_branch_arrival_time) * time_scaler;
-		double current_branch_reward_rate = branchtime ? cluster_laid_eggs / branchtime : 0.0;
-		sigs->push_back(sigmoid(current_branch_reward_rate)); // Reward rate.
+/**
+ * Collects the input signals for the neuronal network. The WASP_NN_INPUTS signals are
+ * written to sigs. If you add one, increase WASP_NN_INPUTS.
+ */
+void Wasp::fill_input_signals(double* sigs, const perception* pcpt) {
+	const wasp_columns& c = cols();
+	// Collected personal statistics as perceptions:
+	sigs[0] = sigmoid(c.foreign_wasp_eggs_seen[row]);	// on current branch
+	sigs[1] = sigmoid(c.empty_fruits_seen[row]);		// on current branch
+	sigs[2] = sigmoid(c.laid_eggs[row]);				// in the whole bush
+	sigs[3] = sigmoid(c.cluster_laid_eggs[row]);		// on current branch
+	sigs[4] = sigmoid(c.fly_eggs_seen[row]);			// on current branch
+	sigs[5] = sigmoid(c.cluster_jumps[row]);			// in the whole bush
+	sigs[6] = sigmoid(c.bad_fruits_seen[row]);		// in the whole bush
+	sigs[7] = sigmoid((pcpt->current_time - birth_time) / (max_age - birth_time)); // Lifetime normalized
 
-		// A static input for the neuronal network.
-		// sigs->push_back(0.5);
-		
-		// A random input for the neuronal network.
-		// sigs->push_back(World::randone());
-		
-		if (neuronal_network(sigs)) {
-			double branchtime = (pcpt->current_time - last_branch_arrival_time) * time_scaler;
-			if (branchtime)
-				reward_rate_sum += cluster_laid_eggs / branchtime;
-			if (get_genome_ptr()->get_gene(next_gene++) < World::randone())
-				ret.type = GO_TO_BRANCH_WEST;
-			else
-				ret.type = GO_TO_BRANCH_EAST;
-			branch_hopping = true;
-			ret.intensity = (int) (1.0 + get_genome_ptr()->get_gene(next_gene++) * 3.0);
-			foreign_wasp_eggs_seen = 0; // Means wasp eggs on current branch.
-			empty_fruits_seen = 0;
-			fly_eggs_seen = 0;
-			last_branch_leaving_time = pcpt->current_time;
-			++cluster_jumps;
-			cluster_laid_eggs = 0;
-		} else {
-			ret.intensity = 1.0;
-			ret.type = GO_TO_FRUIT;
-		}
-	}
-	return ret;
+	// McNamara-Houston-input (reward rates):
+	double average_reward_rate = c.cluster_jumps[row] ? 
+		c.reward_rate_sum[row] / c.cluster_jumps[row] : 0.0;
+	sigs[8] = sigmoid(average_reward_rate); // Average reward rate.
+	static const double time_scaler = 0.05;
+	double branchtime = (pcpt->current_time - c.last_branch_arrival_time[row]) * time_scaler;
+	double current_branch_reward_rate = branchtime ? c.cluster_laid_eggs[row] / branchtime : 0.0;
+	sigs[9] = sigmoid(current_branch_reward_rate); // Reward rate.
+
+	// Unused inputs. To use one, set WASP_NN_INPUTS to 11.
+	// sigs[10] = 0.5;					// A static input.
+	// sigs[10] = World::randone();		// A random input.
 }
 
 /**
- * Returns true, because this wasp is a parasitoid.
+ * Last step of a cognition: turns the decision of the neuronal network (leave the branch
+ * or not) into an action.
  */
-bool Wasp::is_parasitoid() {
-	return true;
+void Wasp::decide(const perception* pcpt, const bool leave, action* ret) {
+	if (leave) {
+		wasp_columns& c = cols();
+		static const double time_scaler = 0.05;
+		double branchtime = (pcpt->current_time - c.last_branch_arrival_time[row]) * time_scaler;
+		if (branchtime)
+			c.reward_rate_sum[row] += c.cluster_laid_eggs[row] / branchtime;
+		if (get_genome_ptr()->get_gene(next_gene++) < World::randone())
+			ret->type = GO_TO_BRANCH_WEST;
+		else
+			ret->type = GO_TO_BRANCH_EAST;
+		c.branch_hopping[row] = true;
+		ret->intensity = (int) (1.0 + get_genome_ptr()->get_gene(next_gene++) * 3.0);
+		c.foreign_wasp_eggs_seen[row] = 0; // Means wasp eggs on current branch.
+		c.empty_fruits_seen[row] = 0;
+		c.fly_eggs_seen[row] = 0;
+		c.last_branch_leaving_time[row] = pcpt->current_time;
+		++c.cluster_jumps[row];
+		c.cluster_laid_eggs[row] = 0;
+	} else {
+		ret->intensity = 1.0;
+		ret->type = GO_TO_FRUIT;
+	}
 }
@@ -12,6 +12,11 @@
 #include "debug_macros.h"
 
 #define GENOME_SIZE 4
+/** Quantity of input signals of the neuronal network of a wasp. */
+#define WASP_NN_INPUTS 10
+/** A narrower hidden layer width for wasps (see Agent::set_nn_hidden_width). Networks
+    with it are computed by code made for their size. */
+#define WASP_NN_NARROW_WIDTH 4
 
 class Wasp;
 typedef std::shared_ptr<Wasp> wasp_ptr;
@@ -20,30 +25,25 @@ typedef std::shared_ptr<Wasp> wasp_ptr;
 /**
  * A Wasp is an insect. This kind of wasp likes to put its eggs into the eggs of flys.
  */
-class Wasp : public Insect {
+class Wasp final : public Insect {
 	
 	public:
 		Wasp(genome_ptr mygen = genome_ptr(new Genome(typeid(Wasp), GENOME_SIZE)));
 		action cognite(const perception* agents_personal_perception);
-		bool is_parasitoid();
+		void cognite_batch(const agent_ptr* agents, const perception* perceptions,
+		                   action* actions, const unsigned int quantity,
+		                   cognition_batch& scratch);
+		void join_store(InsectStore* store);
 
 	protected:
 
 	private:
-		/** Quantity of found fly eggs in the current branch. */
-		unsigned int fly_eggs_seen;
-		/** Quantity of found empty fruits in the current branch. */
-		unsigned int empty_fruits_seen;
-		/** Quantity of found eggs of the own genome in the current branch. */
-		unsigned int own_eggs_seen;
-		/** Quantity of found eggs of a different wasp genome in the current branch. */
-		unsigned int foreign_wasp_eggs_seen;
-		/** All eggs this wasp laid. */
-		unsigned int laid_eggs;
-		/** Laid eggs in the current cluster. */
-		unsigned int cluster_laid_eggs;
-		/** All found fruits where no laying was possible. */
-		unsigned int bad_fruits_seen;
+		/** Returns the columns with the state of the wasps. */
+		inline wasp_columns& cols() const { return *static_cast<wasp_columns*>(columns); }
+
+		bool perceive(const perception* pcpt, action* ret);
+		void fill_input_signals(double* sigs, const perception* pcpt);
+		void decide(const perception* pcpt, const bool leave, action* ret);
 };
 
 #endif // _WASP_H_
@@ -5,11 +5,11 @@
  * 
  */
 
+#include <algorithm>
 #include <list>
 #include <limits>
 #include <cstdlib>
-#include <sys/time.h>
-#include <unistd.h>
+#include <initializer_list>
 
 #include "world.h"
 #include "genome.h"
@@ -17,6 +17,25 @@
 #include "insect.h"
 
 
+/**
+ * Creates empty scratch memory.
+ */
+cognition_batch::cognition_batch() {
+}
+
+/**
+ * Creates empty scratch memory. Nothing is copied, it is only scratch.
+ */
+cognition_batch::cognition_batch(const cognition_batch& other) {
+}
+
+/**
+ * Keeps this scratch memory as it is.
+ */
+cognition_batch& cognition_batch::operator=(const cognition_batch& other) {
+	return *this;
+}
+
 /**
  * Contructs a new World without agents.
  */
@@ -26,7 +45,10 @@ World::World() :
 	max_redundant_generation_reiterations(1),
 	current_generation(0),
 	max_turns_per_generation(std::numeric_limits<turn_counter>::max()),
-	recombination(true)
+	recombination(true),
+	cognition_window(0.0),
+	random_seed(RNG_DEFAULT_SEED),
+	variance_reduction_mode(VR_NONE)
 {
 	genepool = genome_container_ptr(new genome_container);
 	
@@ -34,13 +56,6 @@ World::World() :
 	standard_agent_type_parameter.dynamic_offspring = false;
 	standard_agent_type_parameter.best_agent = agent_ptr();
 	standard_agent_type_parameter.best_genomes_fitness = 0.0;
-
-
-	// std::default_random_engine _engine;
-	// Getting a really unpredictable random seed:
-	struct timeval tv;
-	gettimeofday(&tv, 0);
-	srand(tv.tv_usec * getpid());
 }
 
 /**
@@ -71,8 +86,8 @@ void World::delete_agent_fitnesses_statistics() {
  * Offspring fitness is calculated by another mechanism; therefore fitness is stored by
  * genome (genotype) and not by agent.
  */
-void World::inc_agent_fitness_statistic(agent_ptr cooper, double add_fit) {
-	BUG_CHECK(!cooper, "Agent pointer to nowhere.");
+void World::inc_agent_fitness_statistic(const agent_handle cooper_handle, double add_fit) {
+	const agent_ptr& cooper = population.get(cooper_handle);
 	agent_type_parameter_container::iterator ainfo_i = agent_type_infos.find(&typeid(*cooper));
 	BUG_CHECK(ainfo_i == agent_type_infos.end(), "Agent type info not found.");
 	cooper->inc_personal_fitness(add_fit);
@@ -145,14 +160,80 @@ void World::set_all_fitnesses(double new_fit) {
 }
 
 /**
- * Returns the average fitness value per agent for the given agents_type.
+ * Returns a genome with the mean gene values of the given genomes of the given type,
+ * weighted by their offspring quantities, or an empty pointer if there are none.
  */
-double World::get_average_fitness(const std::type_info* agents_type) {
+static genome_ptr average_of(const genome_container& genomes,
+                             const std::type_info& average_agents_type) {
+	genome_ptr avg_g;
+	unsigned int individuals = 0;
+
+	// Sum all the appropriate genomes.
+	for (auto const& genome: genomes) 
+		if (genome->agents_type_equals(average_agents_type)  && 
+		    genome->get_offspring_quantity()) {
+			if (!avg_g)				
+				avg_g = genome_ptr(new Genome(*genome->get_type_id(), genome->size(), 0.0));
+			*avg_g += *genome * (double)genome->get_offspring_quantity(); 
+			avg_g->increase_fitness(genome->get_fitness());
+			individuals += genome->get_offspring_quantity();
+		} 
+
+	// If no genomes were found return an empty pointer.
+	if (!avg_g) { 
+		debug_msg("Bug? No genomes found!");
+		return avg_g; 
+	}
+
+	// If no agents were found return an empty pointer.
+	if (!individuals) {
+		genome_ptr null_pointer_genome;
+		return null_pointer_genome;
+	}
+	
+	// Divide all sums by the amount of accumulated agents.
+	(*avg_g) /= (double)individuals;
+	avg_g->set_fitness(avg_g->get_fitness() / (double)individuals);
+	//avg_g->add_fitness_to_average();
+
+	// Add an "Average" to the describing type string.
+	avg_g->attach_agents_name("Average ");
+	return avg_g;
+}
+
+/**
+ * Returns a copy of the genome with the highest fitness among the given genomes of the
+ * given type, or an empty pointer if there is none.
+ */
+static genome_ptr best_of(const genome_container& genomes,
+                          const std::type_info& best_agents_type) {
+	genome_ptr best_g;
+	for (auto const& genome: genomes)
+		if (genome->agents_type_equals(best_agents_type)) {
+			if (!best_g) {
+				best_g = genome;
+			} else {
+				if (genome->get_fitness() > best_g->get_fitness())
+					best_g = genome;
+			}
+		}
+	if (!best_g)
+		return best_g;
+	genome_ptr copy_of_best_g = genome_ptr(new Genome(*best_g));
+	copy_of_best_g->attach_agents_name("Best ");
+	return copy_of_best_g;
+}
+
+/**
+ * Returns the average fitness per agent of the given genomes of the given type.
+ */
+static double average_fitness_of(const genome_container& genomes,
+                                 const std::type_info& agents_type) {
 	double fitness_amount = 0.0;
 	unsigned int agent_amount = 0;
 	
-	for (auto const& genome: *genepool)
-		if (genome->agents_type_equals(*agents_type)) {
+	for (auto const& genome: genomes)
+		if (genome->agents_type_equals(agents_type)) {
 			fitness_amount += genome->get_fitness();
 			agent_amount += genome->get_offspring_quantity();
 		}
@@ -160,6 +241,13 @@ double World::get_average_fitness(const std::type_info* agents_type) {
 	return agent_amount ? fitness_amount /  (double) agent_amount : 0.0;
 }
 
+/**
+ * Returns the average fitness value per agent for the given agents_type.
+ */
+double World::get_average_fitness(const std::type_info* agents_type) {
+	return average_fitness_of(*genepool, *agents_type);
+}
+
 /**
  * Returns the fitness of the best agent of the given type.
  * This fitness is not calculated here. This method returns only a stored value. The value
@@ -254,6 +342,49 @@ void World::recreate_world() {
 
 }
 
+/**
+ * Makes this world ready for one reiteration of the generation of the given master
+ * world, in place: the population is cleared, the genepool and the parameters are
+ * taken from the master. The memory of this world is kept. Only the master is read, so
+ * many workers can load from it at the same time.
+ * Should be extended by a childclass with its own parameters and world structure.
+ */
+void World::load_generation(const World& master) {
+	BUG_CHECK(genepool == master.genepool, "A world can not load its own genepool.");
+	clear_population();
+	current_generation = master.current_generation;
+	max_turns_per_generation = master.max_turns_per_generation;
+	max_redundant_generation_reiterations = master.max_redundant_generation_reiterations;
+	recombination = master.recombination;
+	cognition_window = master.cognition_window;
+	random_seed = master.random_seed;
+	variance_reduction_mode = master.variance_reduction_mode;
+	standard_agent_type_parameter = master.standard_agent_type_parameter;
+	for (auto const& master_info: master.agent_type_infos) {
+		create_agent_type(master_info.first);
+		agent_type_parameter& info = agent_type_infos[master_info.first];
+		info.offspring_quantity = master_info.second.offspring_quantity;
+		info.dynamic_offspring = master_info.second.dynamic_offspring;
+	}
+	load_genepool(*master.genepool);
+}
+
+/**
+ * Makes the genepool equal to the given one. The genomes of this world are overwritten
+ * one by one, so their genes keep their memory.
+ */
+void World::load_genepool(const genome_container& master_genepool) {
+	auto genome_i = genepool->begin();
+	for (auto const& master_genome: master_genepool) {
+		if (genome_i == genepool->end())
+			genome_i = genepool->insert(genome_i, genome_ptr(new Genome(*master_genome)));
+		else
+			**genome_i = *master_genome;
+		++genome_i;
+	}
+	genepool->erase(genome_i, genepool->end());
+}
+
 /**
  * Returns the number of offspring agents created every generation for the given type.
  */
@@ -272,16 +403,154 @@ unsigned int World::get_different_agent_type_number() const {
 /**
  * Sets the 'seed' value for the used random-value-creation-technique. 
  * You can use this method to have the same series of 'random' values in every run.
- * Therefore create your world(s) first, and then run this method one time. Every world
- * constructor sets a different and unpredictable seed, that's why you have to run this
- * method afterwards.
- * This does not work and makes no sense in a multithreaded environment, which means you
- * have compiled LEvoSim with OpenMP and have set parallel world computations 
- * (vie World::set_max_generation_reiterations) to more than 1.
+ * Every generation and every parallel reiteration of it gets its own engine seeded from
+ * it (see World::reseed), so a run gives the same results with any quantity of threads.
+ * All worlds start with the same seed.
+ */
+void World::set_random_seed(const unsigned long new_seed) {
+	random_seed = new_seed;
+}
+
+/**
+ * Returns the seed of the run, see World::set_random_seed.
+ */
+unsigned long World::get_random_seed() const {
+	return random_seed;
+}
+
+/**
+ * Mixes the given numbers into a seed with SplitMix64 steps.
+ */
+static unsigned long long mix_seed(unsigned long long seed,
+                                   std::initializer_list<unsigned long long> parts) {
+	for (unsigned long long part: parts) {
+		seed += 0x9e3779b97f4a7c15ull + part;
+		seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ull;
+		seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebull;
+		seed ^= seed >> 31;
+	}
+	return seed;
+}
+
+/**
+ * Seeds the generator of this world for the given reiteration of the current generation.
+ * Zero is used for the world which collects the reiterations. The seed is mixed from
+ * the run seed, the generation and the reiteration, so the generators of all
+ * reiterations are independent of each other.
+ * With variance reduction the environment generator is seeded, too: with VR_COMMON
+ * without the generation, and with VR_ANTITHETIC from the pair of the reiteration
+ * (1 and 2, 3 and 4, ...) and mirrored for the second one of a pair.
+ */
+void World::reseed(const unsigned int reiteration) {
+	random_generator.seed(mix_seed(random_seed, {(unsigned long long)current_generation,
+	                                             reiteration}));
+	if (!variance_reduction_mode)
+		return;
+
+	unsigned long long generation = (variance_reduction_mode & VR_COMMON) ?
+		0 : current_generation + 1;
+	unsigned int stream = reiteration;
+	bool mirrored = false;
+	if ((variance_reduction_mode & VR_ANTITHETIC) && reiteration) {
+		stream = (reiteration + 1) / 2;
+		mirrored = !(reiteration % 2);
+	}
+	environment_generator.seed(mix_seed(~random_seed, {generation, stream}), mirrored);
+}
+
+/**
+ * Sets how the random numbers of the environment (fruit placement and death draws) are
+ * coordinated between the reiterations of a generation. It takes a combination of the
+ * variance_reduction flags.
+ * Common random numbers (VR_COMMON) make the fitness of a genome comparable between
+ * generations, because it meets the same environment. Antithetic pairs (VR_ANTITHETIC)
+ * make the environment of two reiterations as different as possible, so their average
+ * is nearer to the true fitness. Whether it helps can be seen in the fitness variances
+ * of the genomes (see World::reduce_fitness).
+ */
+void World::set_variance_reduction(const int new_mode) {
+	BUG_CHECK(new_mode & ~(VR_COMMON | VR_ANTITHETIC), "Unknown variance reduction: " <<
+	          new_mode);
+	variance_reduction_mode = new_mode;
+}
+
+/**
+ * Returns the variance_reduction flags of this world.
+ */
+int World::get_variance_reduction() const {
+	return variance_reduction_mode;
+}
+
+/**
+ * Sets the fitness of every genome to its average over the reiterations of a generation,
+ * and estimates how exact that average is. samples contains the fitness of every genome
+ * (at its slot, see Genome::get_slot) in every reiteration, one row of genomes per
+ * reiteration. The variance of the mean is stored in every genome (see
+ * Genome::get_fitness_variance).
+ * Antithetic pairs are not independent, so with VR_ANTITHETIC the averages of the pairs
+ * are taken as samples for the variance (an unpaired last reiteration is left out).
+ * The genomes are computed in parallel, in tasks of FITNESS_REDUCTION_CHUNK genomes.
+ * Each genome sums up its reiterations in their order.
+ */
+void World::reduce_fitness(const std::vector<genome_ptr>& genomes,
+                           const std::vector<double>& samples,
+                           const unsigned int reiterations) {
+	BUG_CHECK(samples.size() != genomes.size() * reiterations, "Wrong sample quantity.");
+	const unsigned int step = (variance_reduction_mode & VR_ANTITHETIC) ? 2 : 1;
+	const unsigned int genome_quantity = genomes.size();
+
+	TaskGroup chunks;
+	for (unsigned first_slot=0; first_slot<genome_quantity;
+	     first_slot+=FITNESS_REDUCTION_CHUNK)
+		chunks.run([&, first_slot] {
+			unsigned int end_slot = std::min(first_slot + FITNESS_REDUCTION_CHUNK,
+			                                 genome_quantity);
+			for (unsigned slot=first_slot; slot<end_slot; ++slot) {
+				double fitness = 0.0;
+				for (unsigned r=0; r<reiterations; ++r)
+					fitness += samples[r * genome_quantity + slot];
+				genomes[slot]->set_fitness(fitness / reiterations);
+
+				double sum = 0.0;
+				double square_sum = 0.0;
+				unsigned int quantity = 0;
+				for (unsigned first=0; first+step<=reiterations; first+=step) {
+					double sample = 0.0;
+					for (unsigned r=first; r<first+step; ++r)
+						sample += samples[r * genome_quantity + slot];
+					sample /= step;
+					sum += sample;
+					square_sum += sample * sample;
+					++quantity;
+				}
+				double variance = 0.0;
+				if (quantity > 1) {
+					double mean = sum / quantity;
+					variance = std::max(0.0, (square_sum - quantity * mean * mean) /
+					                         (quantity - 1)) / quantity;
+				}
+				genomes[slot]->set_fitness_variance(variance);
+			}
+		});
+	chunks.wait();
+}
+
+/**
+ * Returns the average fitness variance of the genomes of the given type which have
+ * offspring, see World::reduce_fitness.
  */
-//void World::set_random_seed(const unsigned int new_seed) {
-//	srand(new_seed);
-//}
+double World::get_average_fitness_variance(const std::type_info* agents_type) {
+	double variance_sum = 0.0;
+	unsigned int genome_quantity = 0;
+
+	for (auto const& genome: *genepool)
+		if (genome->agents_type_equals(*agents_type) && genome->get_offspring_quantity()) {
+			variance_sum += genome->get_fitness_variance();
+			++genome_quantity;
+		}
+
+	return genome_quantity ? variance_sum / (double) genome_quantity : 0.0;
+}
 
 /**
  * Sets the point in time after that every agent dies.
@@ -300,15 +569,32 @@ void World::randomize_genes() {
 }
 
 /**
- * Finds and deletes one agent from the population.
- * Erases the pointer from population-list and maybe frees the objects memory.
+ * Deletes one agent from the population, if it is living in this world.
  */
 void World::kill_agent(agent_ptr cooper) {
-	for (auto agent_i = population.begin(); agent_i != population.end(); agent_i++)
-		if (*agent_i == cooper) {
-			population.erase(agent_i);
-			break;
-		}   
+	agent_handle handle = cooper->get_handle();
+	if (population.is_living(handle) && population.get(handle) == cooper)
+		kill_agent(handle);
+}
+
+/**
+ * Deletes the agent with the given handle from the living population.
+ * The agent can still be found by its handle until the population is cleared.
+ */
+void World::kill_agent(const agent_handle cooper) {
+	event_queue.remove(cooper);
+	population.remove(cooper);
+}
+
+/**
+ * Removes all agents from the population without any death statistics. Their handles
+ * become invalid. The arena starts over, its memory is freed as soon as no agent or
+ * other object of the last run is left.
+ */
+void World::clear_population() {
+	event_queue.clear();
+	population.clear();
+	arena.reset();
 }
 
 /**
@@ -319,10 +605,10 @@ void World::kill_agent(agent_ptr cooper) {
  */
 void World::freeze_agents(turn_counter end_time, const std::type_info* agent_type) {
 	for (auto const& agent: population)
-		if (agent_type == NULL)
-			agent->set_action_finishing_time(end_time);
-		else if (*agent_type == typeid(*agent))
+		if (agent_type == NULL || *agent_type == typeid(*agent)) {
 			agent->set_action_finishing_time(end_time);
+			event_queue.update(agent->get_handle(), agent->get_action_finishing_time());
+		}
 }
 
 /**
@@ -359,35 +645,53 @@ void World::set_max_age(turn_counter new_max_age) {
 void World::agent_death_statistics(agent_ptr dead_agent) {
 }
 
+/**
+ * This is called after every new agent in the population has got its handle.
+ * It does nothing, but can be overwritten in orphane classes to put the agent into
+ * the world.
+ */
+void World::agent_added(const agent_ptr& new_agent) {
+}
+
+/**
+ * Lets the given agent cognite. This is the agent type dispatch of World::run_static,
+ * which uses the virtual Agent::cognite here. Worlds with a closed list of agent types
+ * can hide this method with a faster one.
+ */
+action World::dispatch_cognite(const agent_ptr& cooper, const perception* cooper_sees) {
+	return cooper->cognite(cooper_sees);
+}
+
 /**
  * One agent can act one time in a run().
  * Returns true if there is time left for more runs of other agents.
+ * If a cognition window is set, all agents finishing within the window act in one run
+ * (see World::run_batch).
  */
 bool World::run() {
-	// The list of living agents is sorted by the lengths of time they need to complete 
-	// their current action. 
-	population.sort(Agent::compare_finishing_times);
+	if (cognition_window > 0.0)
+		return run_batch();
 
-	// current_agent points to the next (in time) ready agent.
-	agent_container::iterator current_agent = population.begin();
+	// The event queue knows which agent is the next (in time) ready agent.
+	agent_handle current_handle = event_queue.top();
+	const agent_ptr& current_agent = population.get(current_handle);
 
 	// Bug-check for nullpointer.
-	BUG_CHECK(!(*current_agent), "Agent pointer to nowhere.");
+	BUG_CHECK(!current_agent, "Agent pointer to nowhere.");
 	
-	// In the case of death the agent is deleted from the population-list and 
-	// from memory (if there is no other shared pointer to this agent).
+	// In the case of death the agent is deleted from the living population.
 	// This run() is stopped with <true> because there could be other active agents 
 	// in this generation.
-	if ((*current_agent)->died()) {
-		debug_msg("Agent " << *current_agent << " is DEAD.");
-		agent_death_statistics(*current_agent);
-		population.erase(current_agent);
+	if (current_agent->died()) {
+		debug_msg("Agent " << current_agent << " is DEAD.");
+		agent_death_statistics(current_agent);
+		kill_agent(current_handle);
 		return true;
 	}
 	
 	// We 'wait' until the agent has done everything and is ready to do the next.
 	// The 'clock' <turn> is set to the finishing time.
-	turn = (*current_agent)->accomplish_action();
+	turn = current_agent->accomplish_action();
 
 	// If the time for this generation is over we stop everything.
 	if (turn>max_turns_per_generation)
@@ -396,29 +700,120 @@ bool World::run() {
 	// The world must arrange a data struture for this agent, which contains all facts
 	// he should know to decide what he wants to do.
 	perception agents_perception;
-	make_perception(*current_agent, &agents_perception);
+	make_perception(current_agent, &agents_perception);
 
 	// The agent gets his perception, ponders, and gives back what he decided to do next.
-	action what_he_does = (*current_agent)->cognite(&agents_perception);
+	action what_he_does = current_agent->cognite(&agents_perception);
 
 	// The world tries to 'execute' the agents will. There is no certainity that this 
 	// action can be done. World is responsible to decide about the effects of the agents
 	// ambition.
-	execute_action(*current_agent, what_he_does);
+	execute_action(current_agent, what_he_does);
+
+	// The agent has a new action finishing time now and must be queued again.
+	event_queue.reschedule(current_handle, current_agent->get_action_finishing_time());
 	
 	return true;
 }
 
+/**
+ * Lets all agents act which finish their actions within the cognition window after the
+ * next agent. This is the relaxed counterpart of one World::run: every agent perceives the
+ * world before any of the others in the window acts, and all agents of the same type
+ * cognite together via Agent::cognite_batch. Afterwards the actions are executed in the
+ * order of the finishing times.
+ * Returns true if there is time left for more runs.
+ */
+bool World::run_batch() {
+	turn_counter window_end = 
+		population.get(event_queue.top())->get_action_finishing_time() + cognition_window;
+
+	// Take all agents out of the queue which finish in the window. Dead ones are buried.
+	batch.agents.clear();
+	while (!event_queue.empty() && 
+	       population.get(event_queue.top())->get_action_finishing_time() <= window_end) {
+		agent_handle handle = event_queue.pop();
+		const agent_ptr& cooper = population.get(handle);
+		if (cooper->died()) {
+			debug_msg("Agent " << cooper << " is DEAD.");
+			agent_death_statistics(cooper);
+			population.remove(handle);
+		} else
+			batch.agents.push_back(handle);
+	}
+	const unsigned int quantity = batch.agents.size();
+
+	// Every agent finishes its action. If the time for this generation is over we stop.
+	batch.times.resize(quantity);
+	for (unsigned i=0; i<quantity; ++i) {
+		const agent_ptr& cooper = population.get(batch.agents[i]);
+		batch.times[i] = cooper->accomplish_action();
+		if (batch.times[i] > max_turns_per_generation)
+			return false;
+	}
+
+	// The agents are grouped by type, keeping the order inside each group.
+	batch.group_positions.assign(quantity, quantity);
+	batch.grouped_agents.clear();
+	for (unsigned i=0; i<quantity; ++i)
+		if (batch.group_positions[i] == quantity) {
+			const std::type_info& group_type = typeid(*population.get(batch.agents[i]));
+			for (unsigned j=i; j<quantity; ++j)
+				if (batch.group_positions[j] == quantity && 
+				    typeid(*population.get(batch.agents[j])) == group_type) {
+					batch.group_positions[j] = batch.grouped_agents.size();
+					batch.grouped_agents.push_back(population.get(batch.agents[j]));
+				}
+		}
+
+	// Every agent perceives the world at its own finishing time.
+	batch.perceptions.resize(quantity);
+	batch.actions.resize(quantity);
+	for (unsigned i=0; i<quantity; ++i) {
+		turn = batch.times[i];
+		make_perception(population.get(batch.agents[i]),
+		                &batch.perceptions[batch.group_positions[i]]);
+	}
+
+	// All agents of one type cognite together.
+	unsigned int group_begin = 0;
+	while (group_begin < quantity) {
+		const std::type_info& group_type = typeid(*batch.grouped_agents[group_begin]);
+		unsigned int group_end = group_begin + 1;
+		while (group_end < quantity && typeid(*batch.grouped_agents[group_end]) == group_type)
+			++group_end;
+		batch.grouped_agents[group_begin]->cognite_batch(&batch.grouped_agents[group_begin],
+		                                                  &batch.perceptions[group_begin],
+		                                                  &batch.actions[group_begin],
+		                                                  group_end - group_begin, batch);
+		group_begin = group_end;
+	}
+	batch.grouped_agents.clear();
+
+	// The actions are executed in the order of finishing times.
+	for (unsigned i=0; i<quantity; ++i) {
+		turn = batch.times[i];
+		const agent_ptr& cooper = population.get(batch.agents[i]);
+		execute_action(cooper, batch.actions[batch.group_positions[i]]);
+		event_queue.push(batch.agents[i], cooper->get_action_finishing_time(), true);
+	}
+
+	return true;
+}
+
 /**
  * Does some death statistics for all living agents and deletes them afterwards.
  * Call this method if they should be dead will not act anymore.
+ * The dead agents can still be found by their handles (for fitness calculation) until
+ * the population is cleared.
  */
 void World::kill_all_agents() {
 	for (auto const& agent: population) {
 		agent->is_dead_now();
 		agent_death_statistics(agent);
 	}
-	population.clear();
+	event_queue.clear();
+	population.remove_living();
 }
 
 /**
@@ -438,6 +833,24 @@ void World::set_time(turn_counter new_time) {
 	turn = new_time;
 }
 
+/**
+ * Sets the cognition window. If it is zero (the default), agents act strictly one after
+ * the other. Otherwise all agents finishing their actions within this time span after
+ * the next agent perceive, cognite and act together in one run. This is faster, but an
+ * agent does not see what the others in its window do.
+ */
+void World::set_cognition_window(const turn_counter new_window) {
+	BUG_CHECK(new_window < 0.0, "Negative cognition window: " << new_window);
+	cognition_window = new_window;
+}
+
+/**
+ * Returns the cognition window. Zero means strict one-at-a-time cognition.
+ */
+turn_counter World::get_cognition_window() const {
+	return cognition_window;
+}
+
 /**
  * Increase the current_generation counter by the given parameter new_gens.
  */
@@ -464,21 +877,51 @@ double World::get_best_fitness() const {
  */
 genome_ptr World::best_genome(const std::type_info& best_agents_type) {
 	BUG_CHECK(!genepool->size(), "There is no genepool.");
-	genome_ptr best_g;
-	for (auto const& genome: *genepool)
-		if (genome->agents_type_equals(best_agents_type)) {
-			if (!best_g) {
-				best_g = genome;
-			} else {
-				if (genome->get_fitness() > best_g->get_fitness())
-					best_g = genome;
-			}
-		}
-	if (!best_g)
-		return best_g;
-	genome_ptr copy_of_best_g = genome_ptr(new Genome(*best_g));
-	copy_of_best_g->attach_agents_name("Best ");
-	return copy_of_best_g;
+	return best_of(*genepool, best_agents_type);
+}
+
+/**
+ * Returns the statistics of the current generation, which can be collected by another
+ * thread (see StatisticsPipeline). Call it between the generations.
+ */
+world_snapshot_ptr World::make_snapshot() {
+	std::shared_ptr<world_snapshot> snapshot(new world_snapshot);
+	copy_genomes(*snapshot);
+	return snapshot;
+}
+
+/**
+ * Puts the generation number and copies of the genomes of all types of agents into the
+ * given snapshot. Nothing is computed from them here, that is left to the thread which
+ * collects the snapshot (see genome_copies::summarize).
+ */
+void World::copy_genomes(world_snapshot& snapshot) {
+	snapshot.generation = current_generation;
+	for (auto const& ainfo: agent_type_infos) {
+		genome_copies& copies = snapshot.genomes[ainfo.first];
+		copies.agents_type = ainfo.first;
+		copies.has_offspring = ainfo.second.offspring_quantity;
+	}
+	for (auto const& genome: *genepool) {
+		auto copies_i = snapshot.genomes.find(genome->get_type_id());
+		if (copies_i != snapshot.genomes.end())
+			copies_i->second.genomes.push_back(genome_ptr(new Genome(*genome)));
+	}
+}
+
+/**
+ * Returns the average genome, the best genome and the average fitness of the copied
+ * genomes, like World::average_genome, World::best_genome and
+ * World::get_average_fitness do for the genomes of a world. If the type has no
+ * offspring, there is no average genome.
+ */
+genome_summary genome_copies::summarize() const {
+	genome_summary summary;
+	if (has_offspring)
+		summary.average_genome = average_of(genomes, *agents_type);
+	summary.best_genome = best_of(genomes, *agents_type);
+	summary.average_fitness = average_fitness_of(genomes, *agents_type);
+	return summary;
 }
 
 /**
@@ -492,46 +935,15 @@ genome_ptr World::average_genome(const std::type_info& average_agents_type) {
 	BUG_CHECK(atp_i == agent_type_infos.end(), "Can not find agents_type.");
 	if (!atp_i->second.offspring_quantity)
 		return atp_i->second.last_average_genome;
-	genome_ptr avg_g;
-	unsigned int individuals = 0;
-
-	// Sum all the appropriate genomes.
-	for (auto const& genome: *genepool) 
-		if (genome->agents_type_equals(average_agents_type)  && 
-		    genome->get_offspring_quantity()) {
-			if (!avg_g)				
-				avg_g = genome_ptr(new Genome(*genome->get_type_id(), genome->size(), 0.0));
-			*avg_g += *genome * (double)genome->get_offspring_quantity(); 
-			avg_g->increase_fitness(genome->get_fitness());
-			individuals += genome->get_offspring_quantity();
-		} 
-
-	// If no genomes were found return an empty pointer.
-	if (!avg_g) { 
-		debug_msg("Bug? No genomes found!");
-		return avg_g; 
-	}
-
-	// If no agents were found return an empty pointer.
-	if (!individuals) {
-		genome_ptr null_pointer_genome;
-		return null_pointer_genome;
-	}
-	
-	// Divide all sums by the amount of accumulated agents.
-	(*avg_g) /= (double)individuals;
-	avg_g->set_fitness(avg_g->get_fitness() / (double)individuals);
-	//avg_g->add_fitness_to_average();
-
-	// Add an "Average" to the describing type string.
-	avg_g->attach_agents_name("Average ");
+	genome_ptr avg_g = average_of(*genepool, average_agents_type);
 
 	// Store a pointer to this freshly created average genome in the agent type parameters.
-	atp_i->second.last_average_genome = avg_g;
-	
+	if (avg_g)
+		atp_i->second.last_average_genome = avg_g;
 	return avg_g;
 }
 
+
 /**
  * Returns the sum of fitness of all genomes in g_list.
  */
@@ -618,7 +1030,7 @@ genome_container_ptr World::get_genomes_by_type(const std::type_info& agents_t_i
 /**
  * Returns a pointer to the population container.
  */
-agent_container* World::get_population() {
+Population* World::get_population() {
 	return &population;
 }
 
@@ -668,7 +1080,8 @@ void World::add_new_agent(genome_ptr agent_genome, unsigned int quantity) {
 		agent_ptr fresh_agent = create_agent(agent_genome);
 		BUG_CHECK(!fresh_agent->get_genome_ptr(), "New agent has no genome.");
 		agent_genome->set_agents_name(fresh_agent->get_agent_type());
-		population.push_back(std::move(fresh_agent));
+		event_queue.push(population.add(fresh_agent), fresh_agent->get_action_finishing_time());
+		agent_added(fresh_agent);
 	}
 }
 
@@ -741,7 +1154,7 @@ void World::calculate_offspring() {
 genome_ptr World::get_fortune_wheel_genome(agent_type_parameter* atp) {
 	BUG_CHECK(atp->offspring_quantity<1, "No offspring wanted.");
 	BUG_CHECK(!atp->genomes->size(), "Empty genome list.");
-	unsigned int agent_no = (double)atp->offspring_quantity * randone();
+	unsigned int agent_no = randbelow(atp->offspring_quantity);
 	BUG_CHECK(agent_no>=atp->offspring_quantity, "Agent no out of range: " << agent_no);
 
 	genome_container::iterator genome_i = atp->genomes->begin();
@@ -797,3 +1210,7 @@ void World::create_offspring() {
 	for (auto const& genome: *genepool)
 		add_new_agent(genome, genome->get_offspring_quantity());
 }
+
+thread_local RandomGenerator* World::current_generator = NULL;
+thread_local RandomGenerator* World::current_environment_generator = NULL;
+thread_local RandomGenerator World::thread_generator;
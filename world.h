@@ -10,15 +10,23 @@
 
 #include <list>
 #include <map>
-#include <random>
+#include <mutex>
+#include <vector>
 #include "debug_macros.h"
 #include "genome.h"
+#include "event-queue.h"
+#include "arena.h"
+#include "random-generator.h"
+#include "task-pool.h"
 
 
 /** Turns on population dynamics if it is used via  
     set_offspring_quantity(DYNAMIC_OFFSPRING_QUANTITY) */
 #define DYNAMIC_OFFSPRING_QUANTITY -1
 
+/** Quantity of genomes one task of World::reduce_fitness computes. */
+#define FITNESS_REDUCTION_CHUNK 256
+
 /** There must be a definition of struct perception in every child of world. */
 struct perception;
 /** There must be a definition of struct action in every child of world. */
@@ -38,11 +46,23 @@ typedef double turn_counter;
 typedef std::list<genome_ptr> genome_container;
 typedef std::shared_ptr<genome_container> genome_container_ptr;
 
-typedef std::list<agent_ptr> agent_container;
-typedef std::shared_ptr<agent_container> agent_container_ptr;
-
 typedef std::shared_ptr<std::string> string_ptr;
 
+/**
+ * Ways to coordinate the random numbers of the environment (fruit placement and death
+ * draws) between the reiterations of a generation, see World::set_variance_reduction.
+ * The flags can be combined.
+ */
+enum variance_reduction {
+	/** Every reiteration and generation draws independent random numbers. */
+	VR_NONE = 0,
+	/** Reiteration n has the same environment in every generation. */
+	VR_COMMON = 1,
+	/** Reiterations are paired, the second one of a pair gets the mirrored random
+	    numbers of the first one. */
+	VR_ANTITHETIC = 2
+};
+
 
 /**
  * Parameters of one class of agents. For every type (class) of agents which occurs one 
@@ -71,6 +91,134 @@ struct agent_type_parameter {
 typedef std::pair<const std::type_info*, agent_type_parameter> info_agent_pair;
 typedef std::map<const std::type_info*, agent_type_parameter> agent_type_parameter_container;
 
+/** Marks the empty entries of cognition_batch::group_table and the ends of groups. */
+#define NOT_GROUPED 0xffffffffu
+
+/**
+ * Scratch memory for the cognition of several agents at once (see World::run_batch and
+ * Agent::cognite_batch). It is kept between the runs to avoid allocations. Copies are
+ * empty.
+ */
+struct cognition_batch {
+	cognition_batch();
+	cognition_batch(const cognition_batch& other);
+	cognition_batch& operator=(const cognition_batch& other);
+
+	/** Returns room for the given quantity of decisions. */
+	bool* get_decisions(const unsigned int quantity) {
+		if (quantity > decision_capacity) {
+			decisions.reset(new bool[quantity]);
+			decision_capacity = quantity;
+		}
+		return decisions.get();
+	}
+
+	/** The popped agents in the order of their finishing times. */
+	std::vector<agent_handle> agents;
+	/** The finishing time of every popped agent. */
+	std::vector<turn_counter> times;
+	/** Position of every popped agent in the grouped containers below. */
+	std::vector<unsigned int> group_positions;
+	/** The popped agents, grouped by their type. */
+	std::vector<agent_ptr> grouped_agents;
+	/** Perceptions of the grouped agents. */
+	std::vector<perception> perceptions;
+	/** Wanted actions of the grouped agents. */
+	std::vector<action> actions;
+	/** Positions (in their group) of the agents which have to think with their neuronal
+	    networks. */
+	std::vector<unsigned int> thinker_positions;
+	/** These agents. */
+	std::vector<Agent*> thinkers;
+	/** Input signals of the thinkers, one after another. */
+	std::vector<double> signals;
+	/** Decisions of the thinkers, see cognition_batch::get_decisions. */
+	std::unique_ptr<bool[]> decisions;
+	/** Quantity of entries in decisions. */
+	unsigned int decision_capacity = 0;
+	/** Hash table of the agent groups with the same neuronal network (see
+	    Agent::neuronal_networks): the group numbers, or NOT_GROUPED. */
+	std::vector<unsigned int> group_table;
+	/** The first agent of every group. */
+	std::vector<unsigned int> group_firsts;
+	/** The last agent of every group. */
+	std::vector<unsigned int> group_lasts;
+	/** The next agent of the same group for every agent, or NOT_GROUPED. */
+	std::vector<unsigned int> next_members;
+};
+
+/**
+ * Summary of the genomes of one type of agents in one generation.
+ */
+struct genome_summary {
+	/** See World::average_genome. */
+	genome_ptr average_genome;
+	/** See World::best_genome. */
+	genome_ptr best_genome;
+	/** See World::get_average_fitness. */
+	double average_fitness;
+};
+
+/**
+ * Copies of the genomes of one type of agents in one generation, for a world_snapshot.
+ * The simulation only copies them, the thread which collects the snapshot summarizes
+ * them (see genome_copies::summarize).
+ */
+struct genome_copies {
+	genome_summary summarize() const;
+
+	/** The type of the agents. */
+	const std::type_info* agents_type;
+	/** Copies of all genomes of this type. */
+	genome_container genomes;
+	/** False if no agents of this type are made in the next generation. Then there is no
+	    average genome, and World::average_genome gives the last one. */
+	bool has_offspring;
+};
+
+/**
+ * The statistics of one generation of a world (see World::make_snapshot). A snapshot is
+ * never changed after it is made, so other threads can read it while the world computes
+ * the next generations. Worlds with their own statistics extend it.
+ */
+struct world_snapshot {
+	virtual ~world_snapshot() {}
+
+	/** Number of the generation. */
+	int generation;
+	/** The genomes of every type of agents. */
+	std::map<const std::type_info*, genome_copies> genomes;
+};
+typedef std::shared_ptr<const world_snapshot> world_snapshot_ptr;
+
+/**
+ * The statistics of one reiteration of a generation (see World::run_generation). They
+ * are taken from the worker world as soon as the reiteration is finished, so the worker
+ * can compute the next one, and are added to the statistics of the world later, in the
+ * order of the reiterations. Worlds with their own statistics extend it.
+ */
+struct reiteration_statistics {
+	virtual ~reiteration_statistics() {}
+};
+typedef std::unique_ptr<reiteration_statistics> reiteration_statistics_ptr;
+
+/**
+ * The worker worlds of a world which are not in use (see World::run_generation). There
+ * are about as many as threads. Copies of a world don't share them, they start without
+ * workers.
+ */
+struct worker_world_container {
+	worker_world_container() {}
+	worker_world_container(const worker_world_container&) {}
+	worker_world_container& operator=(const worker_world_container&) { return *this; }
+
+	/** The unused workers. */
+	std::vector<world_ptr> worlds;
+	/** Guards the workers, and the statistics of the world while the reiterations of
+	    a generation are computed. */
+	std::mutex mutex;
+};
+
 /**
  * The universe for the simulated agents.
  * This class is abstract and offers functions every world needs. It keeps the data
@@ -92,25 +240,78 @@ public:
 	unsigned int get_different_agent_type_number() const;
 	int get_population_size() const;
 	int get_population_size(const std::type_info* agent_type);
-	agent_container* get_population();
+	Population* get_population();
 	genome_container_ptr get_genepool();
 	void freeze_agents(turn_counter end_time, const std::type_info* agent_type=NULL);
 	int get_generation() const;
 	bool run();
 	void kill_agent(agent_ptr cooper);
+	void kill_agent(const agent_handle cooper);
+	virtual void clear_population();
 	void set_max_turns(const turn_counter new_max_turns);
 	double get_best_fitness() const;
 	static double get_collective_fitness(genome_container_ptr g_list);
 	static void set_genome_offspring(genome_container_ptr g_list, unsigned int new_offspring);
 	genome_ptr average_genome(const std::type_info& average_agents_type);
 	genome_ptr best_genome(const std::type_info& best_agents_type);
+	virtual world_snapshot_ptr make_snapshot();
+
+	/**
+	 * While it exists, World::randone draws from the generator of the given world in the
+	 * thread which created it. Scopes can be nested, the old generator is restored at
+	 * the end.
+	 */
+	class random_scope {
+	public:
+		random_scope(World& world) :
+			previous_generator(current_generator),
+			previous_environment_generator(current_environment_generator)
+		{
+			current_generator = &world.random_generator;
+			current_environment_generator = world.variance_reduction_mode ?
+				&world.environment_generator : &world.random_generator;
+		}
+		~random_scope() {
+			current_generator = previous_generator;
+			current_environment_generator = previous_environment_generator;
+		}
+		random_scope(const random_scope&) = delete;
+		random_scope& operator=(const random_scope&) = delete;
+	private:
+		/** The generator of the enclosing scope, or NULL. */
+		RandomGenerator* previous_generator;
+		/** The environment generator of the enclosing scope, or NULL. */
+		RandomGenerator* previous_environment_generator;
+	};
 
-	/** Returns a random value between 0 and 1. */
+	/** Returns a random value between 0 and 1 (without 1). It is drawn from the
+	    generator of the world this thread works on (see World::random_scope). */
 	inline static double randone() {
-		static std::default_random_engine _engine;
-		std::uniform_real_distribution<double> distribution(0.0, 1.0);
-		return distribution(_engine);
+		return generator().uniform();
 	}
+	/** Returns a random integer of range 0..bound-1, e.g. a random index of a
+	    container with bound elements. */
+	inline static unsigned int randbelow(const unsigned int bound) {
+		return generator().below(bound);
+	}
+	/** The same as World::randone, but for the environment (fruit placement and death
+	    draws), which can be coordinated between reiterations (see
+	    World::set_variance_reduction). */
+	inline static double environment_randone() {
+		return environment_generator_of_thread().uniform();
+	}
+	/** The same as World::randbelow, but for the environment. */
+	inline static unsigned int environment_randbelow(const unsigned int bound) {
+		return environment_generator_of_thread().below(bound);
+	}
+	void set_random_seed(const unsigned long new_seed);
+	unsigned long get_random_seed() const;
+	void reseed(const unsigned int reiteration);
+	void set_variance_reduction(const int new_mode);
+	int get_variance_reduction() const;
+	void reduce_fitness(const std::vector<genome_ptr>& genomes,
+	                    const std::vector<double>& samples, const unsigned int reiterations);
+	double get_average_fitness_variance(const std::type_info* agents_type);
 	void set_mutation_intensity(double new_inten);
 	void set_mutation_rate(double new_rate);
 	void set_mutation_intensity(const std::type_info* agent_type, double new_inten);
@@ -126,6 +327,8 @@ public:
 	void set_max_generation_reiterations(const unsigned int max_reitr);
 	genome_container_ptr genepool_copy();
 	void set_time(turn_counter new_time);
+	void set_cognition_window(const turn_counter new_window);
+	turn_counter get_cognition_window() const;
 	void create_offspring();
 	void calculate_offspring();
 	unsigned int get_max_reiterations() const;
@@ -139,19 +342,61 @@ public:
 
 	virtual void reset_statistics();
 	virtual void recreate_world();
-	virtual void collect_multithread_statistics(world_ptr tmp_world) = 0;
+	virtual void load_generation(const World& master);
+	virtual reiteration_statistics_ptr take_reiteration_statistics() = 0;
+	virtual void collect_multithread_statistics(const reiteration_statistics& statistics) = 0;
 	virtual void finish_multithread_statistics(unsigned int world_runs) = 0;
 
+	/**
+	 * The same as World::run, but all calls into the world and the agents are resolved
+	 * at compile time for the given World_type (which must be the type of this world).
+	 * World_type::make_perception, World_type::execute_action and
+	 * World_type::agent_death_statistics are called directly, and the agents cognite via
+	 * World_type::dispatch_cognite. A world with a closed list of agent types can define
+	 * its own dispatch_cognite without virtual calls; the one of World uses
+	 * Agent::cognite.
+	 */
+	template<class World_type> bool run_static() {
+		if (cognition_window > 0.0)
+			return run_batch();
+
+		World_type& this_world = static_cast<World_type&>(*this);
+		agent_handle current_handle = event_queue.top();
+		auto const& current_agent = this_world.population.get(current_handle);
+		BUG_CHECK(!current_agent, "Agent pointer to nowhere.");
+
+		if (current_agent->died()) {
+			debug_msg("Agent " << current_agent << " is DEAD.");
+			this_world.World_type::agent_death_statistics(current_agent);
+			kill_agent(current_handle);
+			return true;
+		}
+
+		turn = current_agent->accomplish_action();
+		if (turn>max_turns_per_generation)
+			return false;
+
+		perception agents_perception;
+		this_world.World_type::make_perception(current_agent, &agents_perception);
+		action what_he_does = this_world.dispatch_cognite(current_agent, &agents_perception);
+		this_world.World_type::execute_action(current_agent, what_he_does);
+		event_queue.reschedule(current_handle, current_agent->get_action_finishing_time());
+		return true;
+	}
+
 	/**
 	 * Calculates one or more generations for the given world.
 	 * Generations can be calculated in parallel. This means that every generation 
 	 * is computed more than one time to get rid of stochastical effect (noise),
-	 * because fitness average values are taken. If you compile this with OpenMP, 
-	 * all processor cores are used for that.
+	 * because fitness average values are taken. The reiterations are tasks of
+	 * TaskPool::instance, so all processor cores are used for that. Several worlds can
+	 * be calculated at the same time, also from tasks of the pool.
 	 */
 	template<class World_type> static void run_generation(std::shared_ptr<World_type> rel_world,
 														  unsigned int generations=1) {
 		while (generations > 0) {
+			rel_world->reseed(0);
+			random_scope rel_randomness(*rel_world);
 			rel_world->calculate_offspring();
 			rel_world->delete_unused_genomes(); // Delete all genomes without offspring.
 			if (rel_world->does_recombination())
@@ -160,40 +405,87 @@ public:
 			rel_world->set_all_fitnesses(0.0);
 			rel_world->reset_statistics();
 			rel_world->delete_agent_fitnesses_statistics();
+			rel_world->clear_population(); // Frees the memory of the last generation.
 				
 			unsigned int max_reiterations = rel_world->get_max_reiterations();
 				
-#pragma omp parallel for		
-			for (unsigned para_generation=0; para_generation<max_reiterations; ++para_generation) {
-				auto tmp_world = std::shared_ptr<World_type>(new World_type(*rel_world));
-				tmp_world->recreate_world();
-				tmp_world->create_offspring();
-				tmp_world->reset_statistics();
-				tmp_world->set_time(0.0);
-				while (tmp_world->get_population_size() && tmp_world->run());
-				tmp_world->kill_all_agents();
-				tmp_world->calculate_fitness();
-				genome_container::iterator tmp_gen_i = tmp_world->get_genepool()->begin();
-				genome_container::iterator rel_gen_i = rel_world->get_genepool()->begin();
-				BUG_CHECK(tmp_world->get_genepool()->size() != rel_world->get_genepool()->size(),
-						  "Different genepool sizes.");
-				while (rel_gen_i != rel_world->get_genepool()->end()) {
-#pragma omp critical (genome_merging) 
-					(*rel_gen_i)->merge(*tmp_gen_i);
-					BUG_CHECK((*tmp_gen_i)->size() > (*rel_gen_i)->size(), 
-							  "Original genome too small.");
-#pragma omp critical (average_fit_change) 
-					(*rel_gen_i)->increase_fitness((*tmp_gen_i)->get_fitness());
-					++tmp_gen_i;
-					++rel_gen_i;
-				}
-#pragma omp critical (collect_statistics)
-				rel_world->collect_multithread_statistics(tmp_world);
-			}
+			// Every genome gets a slot, its copies in the reiterations keep it.
+			std::vector<genome_ptr> genomes(rel_world->get_genepool()->begin(),
+			                                rel_world->get_genepool()->end());
+			for (unsigned slot=0; slot<genomes.size(); ++slot)
+				genomes[slot]->set_slot(slot);
+			// The fitness of every genome in every reiteration, one row per reiteration.
+			// Every reiteration only writes its own row.
+			std::vector<double> fitness_samples(max_reiterations * genomes.size());
+			// The genome copies which got new genes, per reiteration.
+			std::vector<std::vector<genome_ptr>> grown_genomes(max_reiterations);
 
+			// Every reiteration is a task of the task pool and is computed in a worker
+			// world, which is loaded from this world again for every reiteration. The
+			// statistics of a finished reiteration are taken from the worker, which is
+			// free again at once. They are collected in the order of the reiterations:
+			// statistics which are finished too early wait until the reiterations before
+			// them are collected. So the results do not depend on the quantity of threads.
+			worker_world_container& workers = rel_world->worker_worlds;
+			std::vector<reiteration_statistics_ptr> finished(max_reiterations);
+			unsigned int next_collected = 0;
+			TaskGroup reiterations;
+			for (unsigned para_generation=0; para_generation<max_reiterations; ++para_generation)
+				reiterations.run([&, para_generation] {
+					std::shared_ptr<World_type> tmp_world;
+					bool new_worker = false;
+					{
+						std::lock_guard<std::mutex> lock(workers.mutex);
+						new_worker = workers.worlds.empty();
+						if (new_worker)
+							tmp_world.reset(new World_type(*rel_world));
+						else {
+							tmp_world = std::static_pointer_cast<World_type>(workers.worlds.back());
+							workers.worlds.pop_back();
+						}
+					}
+					if (new_worker)
+						tmp_world->recreate_world(); // Its own bush and genepool.
+					tmp_world->load_generation(*rel_world);
+					tmp_world->reseed(para_generation + 1);
+					random_scope tmp_randomness(*tmp_world);
+					tmp_world->create_offspring();
+					tmp_world->reset_statistics();
+					tmp_world->set_time(0.0);
+					while (tmp_world->get_population_size() && 
+					       tmp_world->template run_static<World_type>());
+					tmp_world->kill_all_agents();
+					tmp_world->calculate_fitness();
+
+					BUG_CHECK(tmp_world->get_genepool()->size() != genomes.size(),
+					          "Different genepool sizes.");
+					double* fitnesses = &fitness_samples[para_generation * genomes.size()];
+					for (auto const& tmp_genome: *tmp_world->get_genepool()) {
+						fitnesses[tmp_genome->get_slot()] = tmp_genome->get_fitness();
+						// The worker reuses its genomes, so a copy is kept.
+						if (tmp_genome->size() > genomes[tmp_genome->get_slot()]->size())
+							grown_genomes[para_generation].push_back(
+								genome_ptr(new Genome(*tmp_genome)));
+					}
+
+					reiteration_statistics_ptr statistics =
+						tmp_world->take_reiteration_statistics();
+					std::lock_guard<std::mutex> lock(workers.mutex);
+					workers.worlds.push_back(tmp_world);
+					finished[para_generation] = std::move(statistics);
+					while (next_collected < max_reiterations && finished[next_collected]) {
+						rel_world->collect_multithread_statistics(*finished[next_collected]);
+						finished[next_collected].reset();
+						++next_collected;
+					}
+				});
+			reiterations.wait();
+
+			for (auto const& grown: grown_genomes)
+				for (auto const& tmp_genome: grown)
+					genomes[tmp_genome->get_slot()]->merge(tmp_genome);
 			rel_world->finish_multithread_statistics(max_reiterations);
-			for (auto const& rel_gen: *rel_world->get_genepool())
-				rel_gen->set_fitness(rel_gen->get_fitness() / max_reiterations);
+			rel_world->reduce_fitness(genomes, fitness_samples, max_reiterations);
 			rel_world->inc_current_generation();
 			--generations;
 		}
@@ -202,8 +494,11 @@ public:
 protected:
 	unsigned int offspring_from_fitness(genome_container_ptr gcp);
 	virtual void agent_death_statistics(agent_ptr dead_agent);
+	virtual void agent_added(const agent_ptr& new_agent);
+	action dispatch_cognite(const agent_ptr& cooper, const perception* cooper_sees);
 	void delete_agent_fitnesses_statistics();
-	void inc_agent_fitness_statistic(agent_ptr cooper, double add_fit = 1.0);
+	void inc_agent_fitness_statistic(const agent_handle cooper, double add_fit = 1.0);
+	void copy_genomes(world_snapshot& snapshot);
 		
 	/** make_perception shall create the chunk of data an agent percieves 
 	    every round. Must be implemented by every world. */
@@ -212,10 +507,15 @@ protected:
 	virtual double calculate_fitness() = 0;
 	virtual agent_ptr create_agent(genome_ptr agent_genome) = 0;
 		
+	/** Memory for the agents and other objects of one generation run. Use
+	    arena.make_shared to create them. */
+	Arena arena;
 	/** Container where all genomes are stored. */
 	genome_container_ptr genepool;
 	/** Container where all agents are stored. */
-	agent_container population;
+	Population population;
+	/** All living agents of the population, ordered by their action finishing times. */
+	EventQueue event_queue;
 	/** Fitness of best genome. NOT of best agent. */
 	double best_fitness;
 	/** Current point in time. This is a real number value. */
@@ -231,7 +531,9 @@ protected:
 		
 		
 private:
+	bool run_batch();
 	void create_agents_from_genomes(genome_container_ptr genome_list);
+	void load_genepool(const genome_container& master_genepool);
 	void delete_unused_genomes();
 	bool create_agent_type(const std::type_info* agent_type);
 	void mutate_genomes();
@@ -244,6 +546,42 @@ private:
 	turn_counter max_turns_per_generation;
 	/** This flag turns genetic recombination on or off. */
 	bool recombination;
+	/** All agents finishing their actions within this time span cognite together.
+	    Zero means strict one-at-a-time cognition. */
+	turn_counter cognition_window;
+	/** Scratch memory for World::run_batch. */
+	cognition_batch batch;
+	/** Seed of the whole run. The generator is seeded from it for every generation and
+	    reiteration (see World::reseed). */
+	unsigned long random_seed;
+	/** The random generator of this world. */
+	RandomGenerator random_generator;
+	/** The generator of the environment if variance reduction is switched on. */
+	RandomGenerator environment_generator;
+	/** The variance_reduction flags of this world. */
+	int variance_reduction_mode;
+	/** The worlds the reiterations of this world are computed in. */
+	worker_world_container worker_worlds;
+
+	/** Returns the generator World::randone uses in this thread. */
+	inline static RandomGenerator& generator() {
+		return current_generator ? *current_generator : thread_generator;
+	}
+	/** Returns the generator World::environment_randone uses in this thread. */
+	inline static RandomGenerator& environment_generator_of_thread() {
+		return current_environment_generator ? *current_environment_generator :
+			thread_generator;
+	}
+
+	/** The generator World::randone uses in this thread, NULL outside of a
+	    World::random_scope. */
+	static thread_local RandomGenerator* current_generator;
+	/** The generator World::environment_randone uses in this thread, NULL outside of a
+	    World::random_scope. */
+	static thread_local RandomGenerator* current_environment_generator;
+	/** The generator World::randone uses outside of a World::random_scope, e.g. while a
+	    world is set up. It has the same fixed seed in every thread. */
+	static thread_local RandomGenerator thread_generator;
 		
 };
 